@@ -0,0 +1,141 @@
+#include "CSyntheticBatch.h"
+
+#include <algorithm>
+#include <random>
+#include <typeinfo>
+#include <unordered_map>
+
+namespace
+{
+	// the generated resources are indexed, their hash codes only have to differ from each other
+	Meta::CResourceAccessInfo MakeResourceAccessInfo(const size_t resource_idx, const Meta::EResourceAccessMode access_mode)
+	{
+		Meta::CResourceAccessInfo info{};
+		info.classHashCode = typeid(CSyntheticBatch).hash_code();
+		info.hashCode = info.classHashCode ^ ((resource_idx + 1) * 0x9E3779B97F4A7C15ull);
+		info.objectHashCode = info.classHashCode;
+		info.accessMode = access_mode;
+		info.className = "CSyntheticBatch";
+		info.memberName = "resource";
+		return info;
+	}
+}
+
+CSyntheticTask::CSyntheticTask(std::vector<Meta::CResourceAccessInfo> resources, const TCost duration)
+	: ITask([duration]
+	{
+		// busy, like a task doing real work
+		const auto end = std::chrono::steady_clock::now() + duration;
+		while (std::chrono::steady_clock::now() < end)
+		{
+		}
+	})
+	, resources(std::move(resources))
+	, duration(duration)
+{
+	SetEstimatedCost(duration);
+}
+
+void CSyntheticTask::AddTaskToBuilder(entt::flow& builder)
+{
+	const auto taskId = reinterpret_cast<entt::id_type>(
+		static_cast<void*>(this) // <- use pointer as uid
+	);
+	builder.bind(taskId);
+	for (const Meta::CResourceAccessInfo& resource : resources)
+	{
+		if (resource.accessMode == Meta::EResourceAccessMode::WRITE)
+			builder.rw(resource.hashCode);
+		else
+			builder.ro(resource.hashCode);
+	}
+}
+
+CSyntheticBatch::CSyntheticBatch(const CConfig& config)
+{
+	std::mt19937 random(config.seed);
+	const size_t numResources = std::max<size_t>(config.numResources, 1);
+	// a sixteenth of the resources, at least one
+	const size_t numHotResources = std::max<size_t>(numResources / 16, 1);
+	std::uniform_int_distribution<size_t> anyResource(0, numResources - 1);
+	std::uniform_int_distribution<size_t> hotResource(0, numHotResources - 1);
+	std::uniform_int_distribution<size_t> numTaskResources(1, std::clamp<size_t>(config.maxResourcesPerTask, 1, numResources));
+	std::bernoulli_distribution isWrite(config.writeRatio);
+	std::bernoulli_distribution isHot(config.hotRatio);
+
+	tasks.reserve(config.numTasks);
+	for (size_t taskIdx = 0; taskIdx < config.numTasks; ++taskIdx)
+	{
+		std::vector<size_t> resourceIndices;
+		const size_t numAccesses = numTaskResources(random);
+		while (resourceIndices.size() < numAccesses)
+		{
+			size_t resourceIdx = isHot(random) ? hotResource(random) : anyResource(random);
+			// the resources of a task are distinct, like filtered resources, the hot set may be smaller than the task
+			while (std::ranges::find(resourceIndices, resourceIdx) != resourceIndices.end())
+				resourceIdx = anyResource(random);
+			resourceIndices.push_back(resourceIdx);
+		}
+
+		std::vector<Meta::CResourceAccessInfo> resources;
+		resources.reserve(resourceIndices.size());
+		for (const size_t resourceIdx : resourceIndices)
+			resources.push_back(MakeResourceAccessInfo(resourceIdx, isWrite(random)
+				                                                        ? Meta::EResourceAccessMode::WRITE
+				                                                        : Meta::EResourceAccessMode::READ));
+		tasks.push_back(std::make_shared<CSyntheticTask>(std::move(resources), config.taskDuration));
+		totalWork += config.taskDuration;
+	}
+	ComputeCriticalPath();
+}
+
+std::queue<std::shared_ptr<ITask>> CSyntheticBatch::MakeTaskQueue() const
+{
+	std::queue<std::shared_ptr<ITask>> taskQueue;
+	for (auto&& task : tasks)
+		taskQueue.push(task);
+	return taskQueue;
+}
+
+CSyntheticBatch::TCost CSyntheticBatch::GetIdealMakespan(const size_t num_workers) const
+{
+	return std::max(criticalPath, totalWork / static_cast<TCost::rep>(std::max<size_t>(num_workers, 1)));
+}
+
+void CSyntheticBatch::ComputeCriticalPath()
+{
+	struct CResourceState
+	{
+		TCost lastWriteFinish = TCost::zero();
+		// latest finish of the readers since the last write
+		TCost lastReadFinish = TCost::zero();
+	};
+
+	// a writer waits for the last writer and its readers, a reader only for the last writer
+	std::unordered_map<size_t, CResourceState> resourceStates;
+	for (auto&& task : tasks)
+	{
+		TCost start = TCost::zero();
+		for (const Meta::CResourceAccessInfo& resource : task->GetResourceAccessInfos())
+		{
+			const CResourceState& state = resourceStates[resource.hashCode];
+			start = std::max(start, state.lastWriteFinish);
+			if (resource.accessMode == Meta::EResourceAccessMode::WRITE)
+				start = std::max(start, state.lastReadFinish);
+		}
+
+		const TCost finish = start + task->GetDuration();
+		for (const Meta::CResourceAccessInfo& resource : task->GetResourceAccessInfos())
+		{
+			CResourceState& state = resourceStates[resource.hashCode];
+			if (resource.accessMode == Meta::EResourceAccessMode::WRITE)
+			{
+				state.lastWriteFinish = finish;
+				state.lastReadFinish = TCost::zero();
+			}
+			else
+				state.lastReadFinish = std::max(state.lastReadFinish, finish);
+		}
+		criticalPath = std::max(criticalPath, finish);
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include <MetaResourceInfo.hpp>
+
+#include "Task.hpp"
+
+/**
+ * \brief Task accessing resources chosen at runtime, so batches of any shape can be generated.
+ *        Its body spins for a fixed duration instead of sleeping, like real work occupying a worker.
+ */
+class CSyntheticTask final : public ITask
+{
+public:
+	CSyntheticTask(std::vector<Meta::CResourceAccessInfo> resources, TCost duration);
+	~CSyntheticTask() override = default;
+
+	size_t GetNumResources() override { return 0; }
+	std::any GetMetaResource(size_t) override { return {}; }
+	std::any GetMetaResources() override { return {}; }
+	void AddTaskToBuilder(entt::flow& builder) override;
+	const std::vector<Meta::CResourceAccessInfo>& GetResourceAccessInfos() const override { return resources; }
+
+	TCost GetDuration() const { return duration; }
+
+private:
+	std::vector<Meta::CResourceAccessInfo> resources;
+	TCost duration;
+};
+
+/**
+ * \brief Batch of synthetic tasks drawn from a set of generated resources.
+ *        The same configuration and seed always generate the same batch.
+ */
+class CSyntheticBatch
+{
+public:
+	using TCost = ITask::TCost;
+
+	struct CConfig
+	{
+		size_t numTasks = 1000;
+		// size of the generated resource set
+		size_t numResources = 256;
+		// every task accesses between one and this number of distinct resources
+		size_t maxResourcesPerTask = 4;
+		// share of the accesses which are writes
+		double writeRatio = 0.3;
+		// share of the accesses going to a small hot set of resources, raises the conflict density
+		double hotRatio = 0.0;
+		TCost taskDuration = std::chrono::microseconds(1);
+		uint32_t seed = 1;
+	};
+
+	explicit CSyntheticBatch(const CConfig& config);
+	~CSyntheticBatch() = default;
+
+	// the tasks in generation order, conflicting tasks have to be executed in this order
+	std::queue<std::shared_ptr<ITask>> MakeTaskQueue() const;
+
+	const std::vector<std::shared_ptr<CSyntheticTask>>& GetTasks() const { return tasks; }
+	// sum of all task durations
+	TCost GetTotalWork() const { return totalWork; }
+	// longest chain of conflicting tasks in queue order, no schedule can be faster
+	TCost GetCriticalPath() const { return criticalPath; }
+	// the larger lower bound of the critical path and the work divided by the workers
+	TCost GetIdealMakespan(size_t num_workers) const;
+
+private:
+	std::vector<std::shared_ptr<CSyntheticTask>> tasks;
+	TCost totalWork = TCost::zero();
+	TCost criticalPath = TCost::zero();
+
+	// earliest finish of every task with unlimited workers
+	void ComputeCriticalPath();
+};
@@ -0,0 +1,403 @@
+/**
+ * Benchmark of the schedulers on synthetic batches.
+ * Every scenario changes one property of a baseline batch (number of tasks, resources, accessed resources per task,
+ * write ratio, conflict density, task duration) and is executed by every scheduler mode for a number of frames.
+ * Results are printed and optionally written as CSV and JSON, e.g. to compare them across scheduler changes:
+ *     benchmark --csv results.csv --json results.json --workers 8 --frames 10
+ * The batch scheduler counts the contention per resource by default. With --contention every frame of the graph mode
+ * is executed once more without the counters, alternately before and after, to measure their overhead.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "CStreamingTaskScheduler.h"
+#include "CSyntheticBatch.h"
+#include "CTaskScheduler.h"
+
+namespace
+{
+	std::atomic<size_t> numAllocations = 0;
+}
+
+// every allocation through new is counted, including those of the workers
+void* operator new(const std::size_t size)
+{
+	numAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size > 0 ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace
+{
+	using TCost = ITask::TCost;
+
+	enum class EMode
+	{
+		GRAPH,
+		LOCKS,
+		STREAMING
+	};
+
+	constexpr std::string_view GetModeName(const EMode mode)
+	{
+		switch (mode)
+		{
+		case EMode::GRAPH: return "graph";
+		case EMode::LOCKS: return "locks";
+		case EMode::STREAMING: return "streaming";
+		}
+		return "";
+	}
+
+	struct COptions
+	{
+		size_t numWorkers = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		size_t numFrames = 5;
+		// the graph of the batch scheduler is a dense matrix, its memory grows with the square of the tasks
+		size_t maxGraphTasks = 4096;
+		size_t maxTasks = 100000;
+		uint32_t seed = 1;
+		// executes the frames of the graph mode with and without the contention counters
+		bool measureContention = false;
+		std::string csvPath;
+		std::string jsonPath;
+	};
+
+	struct CScenario
+	{
+		std::string name;
+		CSyntheticBatch::CConfig config;
+	};
+
+	struct CResult
+	{
+		std::string scenario;
+		EMode mode = EMode::GRAPH;
+		CSyntheticBatch::CConfig config;
+		size_t numWorkers = 0;
+		// medians over the frames
+		TCost graphBuildTime = TCost::zero();
+		TCost makespan = TCost::zero();
+		TCost idealMakespan = TCost::zero();
+		// averages over the frames
+		double overheadPerTaskNs = 0.0;
+		double allocationsPerFrame = 0.0;
+		double localStealsPerFrame = 0.0;
+		double remoteStealsPerFrame = 0.0;
+		double lockWaitsPerFrame = 0.0;
+		// fastest makespan with the contention counters over the one without them, 0 if not measured
+		double contentionOverheadPercent = 0.0;
+		// peak resident set of the process during the scenario, 0 if unknown
+		size_t peakRssKb = 0;
+	};
+
+	// resets the peak resident set, so it is measured per scenario
+	void ResetPeakRss()
+	{
+#ifdef __linux__
+		std::ofstream clearRefs("/proc/self/clear_refs");
+		clearRefs << "5";
+#endif
+	}
+
+	size_t GetPeakRssKb()
+	{
+#ifdef __linux__
+		std::ifstream status("/proc/self/status");
+		std::string line;
+		while (std::getline(status, line))
+			if (line.starts_with("VmHWM:"))
+				return std::stoull(line.substr(6));
+#endif
+		return 0;
+	}
+
+	TCost GetMedian(std::vector<TCost> values)
+	{
+		if (values.empty())
+			return TCost::zero();
+		std::ranges::sort(values);
+		return values.at(values.size() / 2);
+	}
+
+	std::vector<CScenario> MakeScenarios(const COptions& options)
+	{
+		const CSyntheticBatch::CConfig baseline{.seed = options.seed};
+		std::vector<CScenario> scenarios;
+		auto addScenario = [&](std::string name, auto&& change)
+		{
+			CSyntheticBatch::CConfig config = baseline;
+			change(config);
+			if (config.numTasks <= options.maxTasks)
+				scenarios.push_back({std::move(name), config});
+		};
+
+		for (const size_t numTasks : {100, 1000, 10000, 100000})
+			addScenario("tasks=" + std::to_string(numTasks), [&](auto& config) { config.numTasks = numTasks; });
+		for (const size_t numResources : {16, 4096})
+			addScenario("resources=" + std::to_string(numResources), [&](auto& config) { config.numResources = numResources; });
+		for (const size_t maxResourcesPerTask : {1, 16})
+			addScenario("resources_per_task=" + std::to_string(maxResourcesPerTask),
+			            [&](auto& config) { config.maxResourcesPerTask = maxResourcesPerTask; });
+		for (const double writeRatio : {0.1, 0.9})
+			addScenario("write_ratio=" + std::to_string(writeRatio).substr(0, 3),
+			            [&](auto& config) { config.writeRatio = writeRatio; });
+		for (const double hotRatio : {0.5, 0.9})
+			addScenario("hot_ratio=" + std::to_string(hotRatio).substr(0, 3), [&](auto& config) { config.hotRatio = hotRatio; });
+		for (const int durationUs : {0, 20})
+			addScenario("duration_us=" + std::to_string(durationUs),
+			            [&](auto& config) { config.taskDuration = std::chrono::microseconds(durationUs); });
+		return scenarios;
+	}
+
+	CResult RunScenario(const CScenario& scenario, const CSyntheticBatch& batch, const EMode mode, const COptions& options)
+	{
+		CResult result;
+		result.scenario = scenario.name;
+		result.mode = mode;
+		result.config = scenario.config;
+		result.numWorkers = options.numWorkers;
+		result.idealMakespan = batch.GetIdealMakespan(options.numWorkers);
+
+		CTaskScheduler batchScheduler(mode == EMode::STREAMING ? 1 : options.numWorkers);
+		if (mode == EMode::LOCKS)
+			batchScheduler.SetLockModeThreshold(scenario.config.numTasks);
+		CStreamingTaskScheduler streamingScheduler(mode == EMode::STREAMING ? options.numWorkers : 1);
+		CWorkerPool& workerPool = mode == EMode::STREAMING
+			                          ? streamingScheduler.GetWorkerPool()
+			                          : batchScheduler.GetWorkerPool();
+
+		std::vector<TCost> graphBuildTimes;
+		std::vector<TCost> makespans;
+		std::vector<TCost> makespansWithoutCounters;
+		const bool measureContention = options.measureContention && mode == EMode::GRAPH;
+		// the frame without the counters on its own, their allocations and steals are not counted
+		auto executeWithoutCounters = [&]()
+		{
+			batchScheduler.SetContentionCounters(false);
+			std::queue<std::shared_ptr<ITask>> taskQueue = batch.MakeTaskQueue();
+			const auto start = std::chrono::steady_clock::now();
+			batchScheduler.OrderAndExecuteTasks(std::move(taskQueue));
+			makespansWithoutCounters.push_back(
+				std::chrono::duration_cast<TCost>(std::chrono::steady_clock::now() - start));
+			batchScheduler.SetContentionCounters(true);
+		};
+		size_t numAllocationsTotal = 0;
+		size_t numLockWaits = 0;
+		ResetPeakRss();
+		workerPool.ResetStealStats();
+		// the first frame warms up the caches and the allocator
+		for (size_t frame = 0; frame <= options.numFrames; ++frame)
+		{
+			// alternately before and after, so neither profits from the caches warmed up by the other
+			if (measureContention && frame > 0 && frame % 2 == 0)
+				executeWithoutCounters();
+			std::queue<std::shared_ptr<ITask>> taskQueue = batch.MakeTaskQueue();
+			if (frame == 1)
+				workerPool.ResetStealStats();
+
+			const size_t numAllocationsBefore = numAllocations.load();
+			const auto start = std::chrono::steady_clock::now();
+			TCost graphBuildTime = TCost::zero();
+			if (mode == EMode::STREAMING)
+			{
+				// the streaming scheduler has no graph, attaching the tasks to their predecessors is its counterpart
+				const CStreamingTaskScheduler::TFrameId frameId = streamingScheduler.SubmitFrame(std::move(taskQueue));
+				graphBuildTime = std::chrono::duration_cast<TCost>(std::chrono::steady_clock::now() - start);
+				streamingScheduler.WaitFrame(frameId);
+			}
+			else
+			{
+				batchScheduler.OrderAndExecuteTasks(std::move(taskQueue));
+				graphBuildTime = batchScheduler.GetStats().graphBuildTime;
+			}
+			const auto makespan = std::chrono::duration_cast<TCost>(std::chrono::steady_clock::now() - start);
+
+			if (frame == 0)
+				continue;
+			numAllocationsTotal += numAllocations.load() - numAllocationsBefore;
+			if (measureContention && frame % 2 == 1)
+				executeWithoutCounters();
+			numLockWaits += mode == EMode::STREAMING ? 0 : batchScheduler.GetStats().numLockWaits;
+			graphBuildTimes.push_back(graphBuildTime);
+			makespans.push_back(makespan);
+		}
+
+		const double numFrames = static_cast<double>(std::max<size_t>(options.numFrames, 1));
+		const CWorkerPool::CStealStats stealStats = workerPool.GetStealStats();
+		result.graphBuildTime = GetMedian(graphBuildTimes);
+		result.makespan = GetMedian(makespans);
+		result.overheadPerTaskNs = static_cast<double>((result.makespan - result.idealMakespan).count())
+			/ static_cast<double>(std::max<size_t>(scenario.config.numTasks, 1));
+		result.allocationsPerFrame = static_cast<double>(numAllocationsTotal) / numFrames;
+		result.localStealsPerFrame = static_cast<double>(stealStats.numLocalSteals) / numFrames;
+		result.remoteStealsPerFrame = static_cast<double>(stealStats.numRemoteSteals) / numFrames;
+		result.lockWaitsPerFrame = static_cast<double>(numLockWaits) / numFrames;
+		if (measureContention)
+		{
+			// the fastest frames, other processes only ever make a frame slower, which hides an overhead below 1%
+			const TCost fastestWithCounters = std::ranges::min(makespans);
+			const TCost fastestWithoutCounters = std::ranges::min(makespansWithoutCounters);
+			result.contentionOverheadPercent = 100.0 * static_cast<double>((fastestWithCounters - fastestWithoutCounters).count())
+				/ static_cast<double>(std::max<TCost::rep>(fastestWithoutCounters.count(), 1));
+		}
+		result.peakRssKb = GetPeakRssKb();
+		return result;
+	}
+
+	void WriteCsv(std::ostream& out, const std::vector<CResult>& results)
+	{
+		out << "scenario,mode,num_tasks,num_resources,max_resources_per_task,write_ratio,hot_ratio,task_duration_ns,"
+			"num_workers,graph_build_ns,makespan_ns,ideal_makespan_ns,overhead_per_task_ns,allocations_per_frame,"
+			"local_steals_per_frame,remote_steals_per_frame,lock_waits_per_frame,contention_overhead_percent,peak_rss_kb\n";
+		for (const CResult& result : results)
+			out << result.scenario << ',' << GetModeName(result.mode) << ',' << result.config.numTasks << ','
+				<< result.config.numResources << ',' << result.config.maxResourcesPerTask << ','
+				<< result.config.writeRatio << ',' << result.config.hotRatio << ','
+				<< result.config.taskDuration.count() << ',' << result.numWorkers << ','
+				<< result.graphBuildTime.count() << ',' << result.makespan.count() << ','
+				<< result.idealMakespan.count() << ',' << result.overheadPerTaskNs << ','
+				<< result.allocationsPerFrame << ',' << result.localStealsPerFrame << ','
+				<< result.remoteStealsPerFrame << ',' << result.lockWaitsPerFrame << ','
+				<< result.contentionOverheadPercent << ',' << result.peakRssKb << '\n';
+	}
+
+	void WriteJson(std::ostream& out, const std::vector<CResult>& results)
+	{
+		out << "[\n";
+		for (size_t idx = 0; idx < results.size(); ++idx)
+		{
+			const CResult& result = results.at(idx);
+			out << "  {\"scenario\": \"" << result.scenario << "\", \"mode\": \"" << GetModeName(result.mode)
+				<< "\", \"num_tasks\": " << result.config.numTasks
+				<< ", \"num_resources\": " << result.config.numResources
+				<< ", \"max_resources_per_task\": " << result.config.maxResourcesPerTask
+				<< ", \"write_ratio\": " << result.config.writeRatio
+				<< ", \"hot_ratio\": " << result.config.hotRatio
+				<< ", \"task_duration_ns\": " << result.config.taskDuration.count()
+				<< ", \"num_workers\": " << result.numWorkers
+				<< ", \"graph_build_ns\": " << result.graphBuildTime.count()
+				<< ", \"makespan_ns\": " << result.makespan.count()
+				<< ", \"ideal_makespan_ns\": " << result.idealMakespan.count()
+				<< ", \"overhead_per_task_ns\": " << result.overheadPerTaskNs
+				<< ", \"allocations_per_frame\": " << result.allocationsPerFrame
+				<< ", \"local_steals_per_frame\": " << result.localStealsPerFrame
+				<< ", \"remote_steals_per_frame\": " << result.remoteStealsPerFrame
+				<< ", \"lock_waits_per_frame\": " << result.lockWaitsPerFrame
+				<< ", \"contention_overhead_percent\": " << result.contentionOverheadPercent
+				<< ", \"peak_rss_kb\": " << result.peakRssKb << '}'
+				<< (idx + 1 < results.size() ? ",\n" : "\n");
+		}
+		out << "]\n";
+	}
+
+	bool ParseOptions(const int argc, char** argv, COptions& options)
+	{
+		for (int idx = 1; idx < argc; ++idx)
+		{
+			const std::string_view arg = argv[idx];
+			if (arg == "--quick")
+			{
+				options.maxTasks = 10000;
+				continue;
+			}
+			if (arg == "--contention")
+			{
+				options.measureContention = true;
+				continue;
+			}
+			if (idx + 1 >= argc)
+				return false;
+			const std::string value = argv[++idx];
+			if (arg == "--csv")
+				options.csvPath = value;
+			else if (arg == "--json")
+				options.jsonPath = value;
+			else if (arg == "--workers")
+				options.numWorkers = std::max<size_t>(std::stoull(value), 1);
+			else if (arg == "--frames")
+				options.numFrames = std::max<size_t>(std::stoull(value), 1);
+			else if (arg == "--max-graph-tasks")
+				options.maxGraphTasks = std::stoull(value);
+			else if (arg == "--max-tasks")
+				options.maxTasks = std::stoull(value);
+			else if (arg == "--seed")
+				options.seed = static_cast<uint32_t>(std::stoul(value));
+			else
+				return false;
+		}
+		return true;
+	}
+}
+
+int main(const int argc, char** argv)
+{
+	COptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		std::cerr << "Usage: benchmark [--csv path] [--json path] [--workers n] [--frames n] [--max-graph-tasks n]"
+			" [--max-tasks n] [--seed n] [--quick] [--contention]" << std::endl;
+		return 1;
+	}
+
+	std::vector<CResult> results;
+	for (const CScenario& scenario : MakeScenarios(options))
+	{
+		const CSyntheticBatch batch(scenario.config);
+		for (const EMode mode : {EMode::GRAPH, EMode::LOCKS, EMode::STREAMING})
+		{
+			if (mode == EMode::GRAPH && scenario.config.numTasks > options.maxGraphTasks)
+			{
+				std::cout << scenario.name << " " << GetModeName(mode) << ": skipped, more than "
+					<< options.maxGraphTasks << " tasks" << std::endl;
+				continue;
+			}
+			results.push_back(RunScenario(scenario, batch, mode, options));
+			const CResult& result = results.back();
+			std::cout << scenario.name << " " << GetModeName(mode)
+				<< ": makespan " << result.makespan.count() / 1000 << " us"
+				<< " (ideal " << result.idealMakespan.count() / 1000 << " us)"
+				<< ", graph " << result.graphBuildTime.count() / 1000 << " us"
+				<< ", overhead " << result.overheadPerTaskNs << " ns/task"
+				<< ", " << result.allocationsPerFrame << " allocations/frame"
+				<< ", peak RSS " << result.peakRssKb << " KB";
+			if (options.measureContention && mode == EMode::GRAPH)
+				std::cout << ", contention counters " << std::showpos << result.contentionOverheadPercent << std::noshowpos << "%";
+			std::cout << std::endl;
+		}
+	}
+
+	if (!options.csvPath.empty())
+	{
+		std::ofstream csv(options.csvPath);
+		WriteCsv(csv, results);
+	}
+	if (!options.jsonPath.empty())
+	{
+		std::ofstream json(options.jsonPath);
+		WriteJson(json, results);
+	}
+	return 0;
+}
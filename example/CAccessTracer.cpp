@@ -0,0 +1,184 @@
+#include "CAccessTracer.h"
+
+#include <algorithm>
+#include <ranges>
+
+// take uint64_t, so we can use 64-bit pointers as unique id in the graph builder
+#ifndef ENTT_ID_TYPE
+#define ENTT_ID_TYPE std::uint64_t
+#endif
+// defined id type before include
+#include <include/entt/src/entt/graph/flow.hpp>
+
+#include "CResourceHierarchy.h"
+
+CAccessTracer::CAccessTracer(const size_t sample_rate)
+	: sampleRate(std::max<size_t>(sample_rate, 1))
+{
+}
+
+void CAccessTracer::TraceTask(const ITask& task)
+{
+	const size_t taskTypeHash = typeid(task).hash_code();
+	const std::vector<Meta::CResourceAccessInfo>& resources = task.GetResourceAccessInfos();
+
+	// hashes of all traced members: resource index, object address, hash
+	struct CSnapshot
+	{
+		size_t resourceIdx;
+		const std::byte* pMember;
+		std::uint64_t hash;
+	};
+	std::vector<CSnapshot> snapshots;
+	{
+		std::scoped_lock lock(mutex);
+		if (executions[taskTypeHash]++ % sampleRate == 0)
+		{
+			for (size_t idx = 0; idx < resources.size(); ++idx)
+			{
+				const Meta::CResourceAccessInfo& resource = resources.at(idx);
+				if (resource.accessMode != Meta::EResourceAccessMode::WRITE
+					|| resource.memberOffset == Meta::UNKNOWN_MEMBER_OFFSET || resource.memberSize == 0)
+					continue;
+				const auto objects = watchedObjects.find(resource.classHashCode);
+				if (objects == watchedObjects.end())
+					continue;
+				for (const std::byte* pObject : objects->second)
+					snapshots.push_back({idx, pObject + resource.memberOffset, 0});
+			}
+		}
+	}
+
+	// the task declared write access, so no other task touches these members while it runs
+	for (CSnapshot& snapshot : snapshots)
+		snapshot.hash = HashBytes(snapshot.pMember, resources.at(snapshot.resourceIdx).memberSize);
+
+	task.DoTask();
+
+	if (snapshots.empty())
+		return;
+
+	// a resource counts as modified if any of the watched objects changed
+	std::vector<bool> modified(resources.size(), false);
+	std::vector<bool> sampled(resources.size(), false);
+	for (const CSnapshot& snapshot : snapshots)
+	{
+		sampled.at(snapshot.resourceIdx) = true;
+		if (HashBytes(snapshot.pMember, resources.at(snapshot.resourceIdx).memberSize) != snapshot.hash)
+			modified.at(snapshot.resourceIdx) = true;
+	}
+
+	std::scoped_lock lock(mutex);
+	for (size_t idx = 0; idx < resources.size(); ++idx)
+	{
+		if (!sampled.at(idx))
+			continue;
+		const Meta::CResourceAccessInfo& resource = resources.at(idx);
+		auto [it, inserted] = writeStats.try_emplace(
+			TWriteKey{taskTypeHash, resource.hashCode},
+			CWriteStats{typeid(task).name(), taskTypeHash, resource.className, resource.memberName, resource.hashCode, 0, 0}
+		);
+		++it->second.numSamples;
+		if (modified.at(idx))
+			++it->second.numModified;
+	}
+}
+
+std::vector<CAccessTracer::CWriteStats> CAccessTracer::GetUnmodifiedWrites() const
+{
+	std::scoped_lock lock(mutex);
+	std::vector<CWriteStats> unmodifiedWrites;
+	for (const CWriteStats& stats : writeStats | std::views::values)
+		if (stats.numSamples > 0 && stats.numModified == 0)
+			unmodifiedWrites.push_back(stats);
+	return unmodifiedWrites;
+}
+
+std::vector<CAccessTracer::CDowngrade> CAccessTracer::GetDowngrades(
+	const std::vector<std::shared_ptr<ITask>>& task_list) const
+{
+	const size_t numDependencies = CountDependencies(task_list, 0, 0);
+
+	std::vector<CDowngrade> downgrades;
+	for (const CWriteStats& stats : GetUnmodifiedWrites())
+	{
+		const bool inBatch = std::ranges::any_of(task_list, [&](const std::shared_ptr<ITask>& task)
+		{
+			return typeid(*task).hash_code() == stats.taskTypeHashCode;
+		});
+		if (!inBatch)
+			continue;
+		const size_t numDowngradedDependencies = CountDependencies(task_list, stats.taskTypeHashCode,
+		                                                           stats.resourceHashCode);
+		downgrades.push_back({stats, numDependencies - numDowngradedDependencies});
+	}
+
+	std::ranges::sort(downgrades, [](const CDowngrade& left, const CDowngrade& right)
+	{
+		return left.removedDependencies > right.removedDependencies;
+	});
+	return downgrades;
+}
+
+void CAccessTracer::PrintReport(std::ostream& stream, const std::vector<CDowngrade>& downgrades)
+{
+	for (const CDowngrade& downgrade : downgrades)
+	{
+		stream << "Unmodified write access " << downgrade.stats.className << "::" << downgrade.stats.memberName
+			<< " in task " << downgrade.stats.taskName << "\n"
+			<< "\tsamples: " << downgrade.stats.numSamples
+			<< ", removed dependencies as read access: " << downgrade.removedDependencies << "\n";
+	}
+}
+
+std::uint64_t CAccessTracer::HashBytes(const std::byte* data, const size_t size)
+{
+	// FNV-1a
+	constexpr std::uint64_t offsetBasis = 0xcbf29ce484222325;
+	constexpr std::uint64_t prime = 0x100000001b3;
+	std::uint64_t hash = offsetBasis;
+	for (size_t idx = 0; idx < size; ++idx)
+	{
+		hash ^= static_cast<std::uint64_t>(data[idx]);
+		hash *= prime;
+	}
+	return hash;
+}
+
+size_t CAccessTracer::CountDependencies(const std::vector<std::shared_ptr<ITask>>& task_list,
+                                        const size_t downgraded_task_type, const size_t downgraded_resource)
+{
+	entt::flow builder{};
+	const CResourceHierarchy resourceHierarchy(task_list);
+	for (size_t idx = 0; idx < task_list.size(); ++idx)
+	{
+		const ITask* pTask = task_list.at(idx).get();
+		const bool downgradedType = typeid(*pTask).hash_code() == downgraded_task_type;
+		builder.bind(idx);
+		for (const Meta::CResourceAccessInfo& resource : pTask->GetResourceAccessInfos())
+		{
+			const bool downgraded = downgradedType && resource.hashCode == downgraded_resource;
+			resource.accessMode == Meta::EResourceAccessMode::WRITE && !downgraded
+				? builder.rw(resource.hashCode)
+				: builder.ro(resource.hashCode);
+		}
+		resourceHierarchy.RegisterImpliedResources(builder, pTask->GetResourceAccessInfos());
+	}
+
+	const entt::adjacency_matrix<entt::directed_tag> graph = builder.graph();
+	const size_t numTasks = graph.size();
+	std::vector<std::vector<bool>> reachable(numTasks, std::vector<bool>(numTasks, false));
+	size_t numDependencies = 0;
+	for (size_t vertex = numTasks; vertex-- > 0;)
+	{
+		for (auto&& [parent, child] : graph.out_edges(vertex))
+		{
+			reachable[vertex][child] = true;
+			for (size_t idx = 0; idx < numTasks; ++idx)
+				if (reachable[child][idx])
+					reachable[vertex][idx] = true;
+		}
+		numDependencies += std::ranges::count(reachable[vertex], true);
+	}
+	return numDependencies;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#include "Task.hpp"
+
+/**
+ * \brief Opt-in tracer that detects over-declared write accesses.
+ *        It hashes the memory of the declared write resources of watched objects before and after a task runs
+ *        and counts how often the task actually modified them.
+ *        Only members with a declared offset (see CPublicMember and CMember) can be traced.
+ *        The hash covers the object representation of the member only,
+ *        so changes behind a pointer (e.g. heap buffer of a std::string) are not detected.
+ */
+class CAccessTracer
+{
+public:
+	struct CWriteStats
+	{
+		std::string_view taskName;
+		size_t taskTypeHashCode;
+		std::string_view className;
+		std::string_view memberName;
+		size_t resourceHashCode;
+		size_t numSamples;
+		size_t numModified;
+	};
+
+	struct CDowngrade
+	{
+		CWriteStats stats;
+		// number of task pairs (including transitive dependencies) that would no longer wait for each other
+		size_t removedDependencies;
+	};
+
+	/**
+	 * \param sample_rate Traces every n-th execution of a task type, 1 traces every execution
+	 */
+	explicit CAccessTracer(size_t sample_rate = 1);
+	~CAccessTracer() = default;
+
+	/**
+	 * \brief Registers an object whose members shall be traced.
+	 *        The object has to outlive the traced tasks.
+	 */
+	template <typename Class>
+	void Watch(const Class& object);
+
+	/**
+	 * \brief Runs the task and traces its declared write accesses, if it is sampled.
+	 *        Safe to call from multiple threads for tasks that do not conflict.
+	 */
+	void TraceTask(const ITask& task);
+
+	// all traced write accesses that were never modified
+	std::vector<CWriteStats> GetUnmodifiedWrites() const;
+
+	/**
+	 * \brief Calculates how many dependencies of the given batch would be removed
+	 *        by downgrading each unmodified write access to a read access.
+	 *        A dependency is a pair of tasks with a path between them, not a single edge of the graph,
+	 *        since removing a transitive edge may add others without letting more tasks run in parallel.
+	 * \param task_list The task batch in the order it would be passed to the scheduler
+	 * \return Unmodified write accesses of tasks in the batch, sorted by removed dependencies
+	 */
+	std::vector<CDowngrade> GetDowngrades(const std::vector<std::shared_ptr<ITask>>& task_list) const;
+
+	static void PrintReport(std::ostream& stream, const std::vector<CDowngrade>& downgrades);
+
+private:
+	// identifies a resource access of a task type
+	using TWriteKey = std::pair<size_t, size_t>; // task type hash, resource hash
+
+	const size_t sampleRate;
+
+	mutable std::mutex mutex;
+	// watched objects per class hash code
+	std::unordered_map<size_t, std::vector<const std::byte*>> watchedObjects;
+	// number of executions per task type hash code
+	std::unordered_map<size_t, size_t> executions;
+	std::map<TWriteKey, CWriteStats> writeStats;
+
+	static std::uint64_t HashBytes(const std::byte* data, size_t size);
+	// counts the pairs of tasks with a path between them in the graph of the batch,
+	// the given resource is registered as read access for all tasks of the given type
+	static size_t CountDependencies(const std::vector<std::shared_ptr<ITask>>& task_list,
+	                                size_t downgraded_task_type, size_t downgraded_resource);
+};
+
+template <typename Class>
+void CAccessTracer::Watch(const Class& object)
+{
+	std::scoped_lock lock(mutex);
+	watchedObjects[typeid(Class).hash_code()].push_back(reinterpret_cast<const std::byte*>(&object));
+}
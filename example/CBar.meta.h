@@ -1,4 +1,6 @@
 #pragma once
+#include <cstddef>
+
 #include <Meta.hpp>
 
 #include "CBar.h"
@@ -10,8 +12,17 @@ namespace Meta::Bar
 	 ************/
 
 	// public:
-	using TSomeNumber = CPublicMember<&CBar::someNumber>;
-	using TSomeString = CPublicMember<&CBar::someString>;
+	// CBar has protected members, so it is not standard-layout and offsetof is only conditionally-supported,
+	// but all major compilers support it
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winvalid-offsetof"
+#endif
+	using TSomeNumber = CPublicMember<&CBar::someNumber, offsetof(CBar, someNumber)>;
+	using TSomeString = CPublicMember<&CBar::someString, offsetof(CBar, someString)>;
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
 	// protected:
 	using TAnotherString = CMember<std::string, "anotherString"_sl>;
 
@@ -34,6 +45,12 @@ namespace Meta::Bar
 	{
 	};
 
+	// all members at once
+	template <EResourceAccessMode AccessMode>
+	struct CObject : CObjectResourceAccess<CBar, AccessMode>
+	{
+	};
+
 	/************
 	 * Methods
 	 ************/
@@ -62,6 +79,14 @@ namespace Meta::Bar
 	struct CSetAnotherString : CMethodResources<CAnotherString<EResourceAccessMode::WRITE>>
 	{
 	};
+
+	struct CPrint : CMethodResources<CObject<EResourceAccessMode::READ>>
+	{
+	};
+
+	struct CReset : CMethodResources<CObject<EResourceAccessMode::WRITE>>
+	{
+	};
 }
 
 namespace Meta
@@ -70,7 +95,8 @@ namespace Meta
 	using TBarResourcesList = TRegisterResources<GLOBAL_METHOD_RESOURCE_LIST,
 	                                             Bar::CPublicReadSomeNumber, Bar::CPublicWriteSomeNumber,
 	                                             Bar::CPublicReadSomeString, Bar::CPublicWriteSomeString,
-	                                             Bar::CMethod, Bar::CSetAnotherString>;
+	                                             Bar::CMethod, Bar::CSetAnotherString,
+	                                             Bar::CPrint, Bar::CReset>;
 	#undef GLOBAL_METHOD_RESOURCE_LIST
 	#define GLOBAL_METHOD_RESOURCE_LIST TBarResourcesList
 }
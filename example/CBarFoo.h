@@ -4,7 +4,7 @@
 class CBarFoo : public IFooBar
 {
 public:
-	~CBarFoo() override;
+	~CBarFoo() override = default;
 
 	int AbstractMethod() override
 	{
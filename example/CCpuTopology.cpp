@@ -0,0 +1,152 @@
+#include "CCpuTopology.h"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+	// parses a cpu list like "0-3,8-11"
+	std::vector<size_t> ParseCpuList(const std::string_view cpu_list)
+	{
+		std::vector<size_t> cpus;
+		size_t pos = 0;
+		while (pos < cpu_list.size())
+		{
+			const size_t end = std::min(cpu_list.find(',', pos), cpu_list.size());
+			const std::string_view range = cpu_list.substr(pos, end - pos);
+			pos = end + 1;
+
+			size_t first = 0;
+			size_t last = 0;
+			const size_t dash = range.find('-');
+			const std::string_view firstText = range.substr(0, dash);
+			if (std::from_chars(firstText.data(), firstText.data() + firstText.size(), first).ec != std::errc{})
+				continue;
+			last = first;
+			if (dash != std::string_view::npos)
+			{
+				const std::string_view lastText = range.substr(dash + 1);
+				if (std::from_chars(lastText.data(), lastText.data() + lastText.size(), last).ec != std::errc{})
+					continue;
+			}
+			for (size_t cpu = first; cpu <= last; ++cpu)
+				cpus.push_back(cpu);
+		}
+		return cpus;
+	}
+
+	// CPUs the process may run on
+	std::vector<size_t> GetAllowedCpus()
+	{
+		std::vector<size_t> cpus;
+#ifdef __linux__
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0)
+		{
+			for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+				if (CPU_ISSET(cpu, &cpuSet))
+					cpus.push_back(cpu);
+			return cpus;
+		}
+#endif
+		const size_t numCpus = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		for (size_t cpu = 0; cpu < numCpus; ++cpu)
+			cpus.push_back(cpu);
+		return cpus;
+	}
+
+	std::vector<CCpuTopology::CNode> ReadNodes()
+	{
+		const std::vector<size_t> allowedCpus = GetAllowedCpus();
+		std::vector<CCpuTopology::CNode> nodes;
+
+#ifdef __linux__
+		const std::filesystem::path nodesPath = "/sys/devices/system/node";
+		std::error_code error;
+		for (const auto& entry : std::filesystem::directory_iterator(nodesPath, error))
+		{
+			const std::string name = entry.path().filename().string();
+			size_t nodeId = 0;
+			if (!name.starts_with("node")
+				|| std::from_chars(name.data() + 4, name.data() + name.size(), nodeId).ec != std::errc{})
+				continue;
+
+			std::ifstream cpuListFile(entry.path() / "cpulist");
+			std::string cpuList;
+			if (!std::getline(cpuListFile, cpuList))
+				continue;
+
+			CCpuTopology::CNode node{nodeId, {}};
+			for (const size_t cpu : ParseCpuList(cpuList))
+				if (std::ranges::binary_search(allowedCpus, cpu))
+					node.cpus.push_back(cpu);
+			if (!node.cpus.empty())
+				nodes.push_back(std::move(node));
+		}
+		std::ranges::sort(nodes, {}, &CCpuTopology::CNode::nodeId);
+#endif
+
+		if (nodes.empty())
+			nodes.push_back({0, allowedCpus});
+		return nodes;
+	}
+}
+
+CCpuTopology::CCpuTopology()
+	: nodes(ReadNodes())
+{
+}
+
+CCpuTopology::CCpuTopology(std::vector<CNode> nodes)
+	: nodes(std::move(nodes))
+{
+}
+
+size_t CCpuTopology::GetNumCpus() const
+{
+	size_t numCpus = 0;
+	for (const CNode& node : nodes)
+		numCpus += node.cpus.size();
+	return numCpus;
+}
+
+std::vector<std::pair<size_t, size_t>> CCpuTopology::AssignWorkers(const size_t num_workers) const
+{
+	// the next free CPU of every node in turn, so a pool smaller than the machine still uses all nodes
+	std::vector<std::pair<size_t, size_t>> nodeCpus;
+	for (size_t round = 0; nodeCpus.size() < GetNumCpus(); ++round)
+		for (size_t nodeIdx = 0; nodeIdx < nodes.size(); ++nodeIdx)
+			if (round < nodes.at(nodeIdx).cpus.size())
+				nodeCpus.emplace_back(nodeIdx, nodes.at(nodeIdx).cpus.at(round));
+
+	std::vector<std::pair<size_t, size_t>> assignments;
+	for (size_t workerIdx = 0; workerIdx < num_workers && !nodeCpus.empty(); ++workerIdx)
+		assignments.push_back(nodeCpus.at(workerIdx % nodeCpus.size()));
+	return assignments;
+}
+
+bool CCpuTopology::PinCurrentThread(const size_t cpu)
+{
+#ifdef __linux__
+	if (cpu >= CPU_SETSIZE)
+		return false;
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	CPU_SET(cpu, &cpuSet);
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#else
+	static_cast<void>(cpu);
+	return false;
+#endif
+}
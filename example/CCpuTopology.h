@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * \brief CPUs grouped by memory node, read at startup.
+ *        On Linux the nodes are read from /sys/devices/system/node, restricted to the CPUs the process may run on.
+ *        Everywhere else, or if the information is missing, all CPUs form a single node.
+ */
+class CCpuTopology
+{
+public:
+	static constexpr size_t NO_NODE = static_cast<size_t>(-1);
+
+	struct CNode
+	{
+		size_t nodeId;
+		std::vector<size_t> cpus;
+	};
+
+	// reads the topology of the machine
+	CCpuTopology();
+	// uses the given nodes, e.g. to simulate another machine
+	explicit CCpuTopology(std::vector<CNode> nodes);
+	~CCpuTopology() = default;
+
+	const std::vector<CNode>& GetNodes() const { return nodes; }
+	size_t GetNumNodes() const { return nodes.size(); }
+	size_t GetNumCpus() const;
+
+	/**
+	 * \brief Assigns a CPU to each of the given number of workers.
+	 *        The workers are spread round-robin over the nodes, each taking the next free CPU of its node,
+	 *        so a pool smaller than the machine still uses the memory of all nodes.
+	 *        If there are more workers than CPUs, the assignment starts over.
+	 * \return Index into GetNodes() and CPU per worker
+	 */
+	std::vector<std::pair<size_t, size_t>> AssignWorkers(size_t num_workers) const;
+
+	/**
+	 * \brief Pins the calling thread to the CPU.
+	 * \return false if pinning is not supported or failed
+	 */
+	static bool PinCurrentThread(size_t cpu);
+
+private:
+	std::vector<CNode> nodes;
+};
@@ -0,0 +1,124 @@
+#include "CFalseSharingAnalyzer.h"
+
+// take uint64_t, so we can use 64-bit pointers as unique id in the graph builder
+#ifndef ENTT_ID_TYPE
+#define ENTT_ID_TYPE std::uint64_t
+#endif
+// defined id type before include
+#include <include/entt/src/entt/graph/flow.hpp>
+
+#include "CResourceHierarchy.h"
+
+namespace
+{
+	// true if both byte ranges may touch a common cache line in some object of the class
+	bool ShareCacheLine(const Meta::CResourceAccessInfo& first, const Meta::CResourceAccessInfo& second,
+	                    const size_t cache_line_size)
+	{
+		const size_t firstEnd = first.memberOffset + first.memberSize;
+		const size_t secondEnd = second.memberOffset + second.memberSize;
+		// objects aligned to the cache line start on a line boundary, so the offsets map to fixed lines
+		if (first.classAlignment >= cache_line_size)
+			return first.memberOffset / cache_line_size <= (secondEnd - 1) / cache_line_size
+				&& second.memberOffset / cache_line_size <= (firstEnd - 1) / cache_line_size;
+		// otherwise the object may start anywhere in a line, two bytes share it if they are closer than a line
+		if (first.memberOffset < secondEnd && second.memberOffset < firstEnd)
+			return true;
+		const size_t distance = first.memberOffset < second.memberOffset
+			                        ? second.memberOffset - (firstEnd - 1)
+			                        : first.memberOffset - (secondEnd - 1);
+		return distance < cache_line_size;
+	}
+
+	// the task type names are mangled on most compilers, the accessed resources tell which task it is
+	void PrintTask(std::ostream& stream, const size_t task_idx, const ITask& task)
+	{
+		stream << "task " << task_idx << " (";
+		const char* separator = "";
+		for (const Meta::CResourceAccessInfo& resource : task.GetResourceAccessInfos())
+		{
+			stream << separator << (resource.accessMode == Meta::EResourceAccessMode::WRITE ? "writes " : "reads ")
+				<< resource.className << "::" << resource.memberName;
+			separator = ", ";
+		}
+		stream << ")";
+	}
+}
+
+std::vector<CFalseSharingAnalyzer::CFalseSharing> CFalseSharingAnalyzer::Analyze(
+	const std::vector<std::shared_ptr<ITask>>& task_list, const size_t cache_line_size)
+{
+	// build the same graph as the scheduler does
+	entt::flow builder{};
+	const CResourceHierarchy resourceHierarchy(task_list);
+	for (auto&& task : task_list)
+	{
+		task->AddTaskToBuilder(builder);
+		resourceHierarchy.RegisterImpliedResources(builder, task->GetResourceAccessInfos());
+	}
+	const entt::adjacency_matrix<entt::directed_tag> graph = builder.graph();
+	const size_t numTasks = graph.size();
+
+	// reachable[a][b] is true if task b runs after task a finished
+	std::vector<std::vector<bool>> reachable(numTasks, std::vector<bool>(numTasks, false));
+	for (size_t vertex = numTasks; vertex-- > 0;)
+		for (auto&& [parent, child] : graph.out_edges(vertex))
+		{
+			reachable[vertex][child] = true;
+			for (size_t idx = 0; idx < numTasks; ++idx)
+				if (reachable[child][idx])
+					reachable[vertex][idx] = true;
+		}
+
+	std::vector<CFalseSharing> falseSharings;
+	for (size_t first = 0; first < numTasks; ++first)
+	{
+		for (size_t second = first + 1; second < numTasks; ++second)
+		{
+			// ordered tasks never run at the same time
+			if (reachable[first][second] || reachable[second][first])
+				continue;
+
+			for (const Meta::CResourceAccessInfo& firstInfo : task_list.at(first)->GetResourceAccessInfos())
+			{
+				if (firstInfo.accessMode != Meta::EResourceAccessMode::WRITE
+					|| firstInfo.memberOffset == Meta::UNKNOWN_MEMBER_OFFSET || firstInfo.memberSize == 0)
+					continue;
+				for (const Meta::CResourceAccessInfo& secondInfo : task_list.at(second)->GetResourceAccessInfos())
+				{
+					if (secondInfo.accessMode != Meta::EResourceAccessMode::WRITE
+						|| secondInfo.memberOffset == Meta::UNKNOWN_MEMBER_OFFSET || secondInfo.memberSize == 0)
+						continue;
+					// only distinct members of the same class
+					if (firstInfo.classHashCode != secondInfo.classHashCode || firstInfo.hashCode == secondInfo.hashCode)
+						continue;
+					if (!ShareCacheLine(firstInfo, secondInfo, cache_line_size))
+						continue;
+
+					falseSharings.push_back({
+						firstInfo.className,
+						firstInfo.memberName, secondInfo.memberName,
+						firstInfo.memberOffset, secondInfo.memberOffset,
+						first, second
+					});
+				}
+			}
+		}
+	}
+
+	return falseSharings;
+}
+
+void CFalseSharingAnalyzer::PrintReport(std::ostream& stream, const std::vector<std::shared_ptr<ITask>>& task_list,
+                                        const std::vector<CFalseSharing>& false_sharings)
+{
+	for (const CFalseSharing& falseSharing : false_sharings)
+	{
+		stream << "False sharing in " << falseSharing.className << ":\n"
+			<< "\t" << falseSharing.firstMember << " (offset " << falseSharing.firstOffset << ") written by ";
+		PrintTask(stream, falseSharing.firstTask, *task_list.at(falseSharing.firstTask));
+		stream << "\n\t" << falseSharing.secondMember << " (offset " << falseSharing.secondOffset << ") written by ";
+		PrintTask(stream, falseSharing.secondTask, *task_list.at(falseSharing.secondTask));
+		stream << "\n";
+	}
+}
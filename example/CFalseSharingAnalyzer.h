@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "Task.hpp"
+
+/**
+ * \brief Diagnostic pass over a task batch:
+ *        finds distinct members of the same class that share a cache line in some object of the class,
+ *        i.e. are closer than a cache line, unless the class is aligned to cache lines
+ *        and are written by tasks that are allowed to run at the same time.
+ *        The scheduler considers these tasks safe, but they will suffer from false sharing.
+ */
+class CFalseSharingAnalyzer
+{
+public:
+	static constexpr size_t CACHE_LINE_SIZE = 64;
+
+	struct CFalseSharing
+	{
+		std::string_view className;
+		std::string_view firstMember;
+		std::string_view secondMember;
+		size_t firstOffset;
+		size_t secondOffset;
+		// index of the tasks inside the analyzed batch
+		size_t firstTask;
+		size_t secondTask;
+	};
+
+	CFalseSharingAnalyzer() = default;
+	~CFalseSharingAnalyzer() = default;
+
+	/**
+	 * \brief Analyzes the given batch in the order it would be passed to the scheduler.
+	 *        Members without a declared offset are skipped.
+	 * \param task_list The task batch
+	 * \param cache_line_size Size of a cache line in bytes
+	 * \return All found pairs of falsely shared members
+	 */
+	static std::vector<CFalseSharing> Analyze(const std::vector<std::shared_ptr<ITask>>& task_list,
+	                                          size_t cache_line_size = CACHE_LINE_SIZE);
+
+	static void PrintReport(std::ostream& stream, const std::vector<std::shared_ptr<ITask>>& task_list,
+	                        const std::vector<CFalseSharing>& false_sharings);
+};
@@ -4,7 +4,7 @@
 class CFooBar : public IFooBar
 {
 public:
-	~CFooBar() override;
+	~CFooBar() override = default;
 
 	int AbstractMethod() override
 	{
@@ -0,0 +1,352 @@
+#include "CIncrementalTaskGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <utility>
+
+// take uint64_t, so we can use 64-bit pointers as unique id in the graph builder
+#ifndef ENTT_ID_TYPE
+#define ENTT_ID_TYPE std::uint64_t
+#endif
+// defined id type before include
+#include <include/entt/src/entt/graph/flow.hpp>
+
+#include "CResourceHierarchy.h"
+
+namespace
+{
+	/**
+	 * \brief Computes the tasks every task waits for directly or indirectly, as one bit set per task.
+	 *        All edges have to point from a lower to a higher index.
+	 */
+	std::vector<std::vector<uint64_t>> ComputeReachability(const std::vector<std::vector<size_t>>& children)
+	{
+		const size_t numTasks = children.size();
+		const size_t numWords = (numTasks + 63) / 64;
+		std::vector<std::vector<uint64_t>> reachable(numTasks, std::vector<uint64_t>(numWords, 0));
+		// the descendants of all children are computed before their parent
+		for (size_t task = numTasks; task-- > 0;)
+			for (const size_t child : children.at(task))
+			{
+				reachable.at(task).at(child / 64) |= uint64_t{1} << (child % 64);
+				for (size_t word = 0; word < numWords; ++word)
+					reachable.at(task).at(word) |= reachable.at(child).at(word);
+			}
+		return reachable;
+	}
+}
+
+void CIncrementalTaskGraph::Insert(std::shared_ptr<ITask> task, size_t position)
+{
+	assert(task && !Contains(*task) && "The task is already part of the graph.");
+	position = std::min(position, order.size());
+
+	auto pOwnedNode = std::make_unique<CNode>();
+	CNode& node = *pOwnedNode;
+	node.task = std::move(task);
+	nodes.emplace(node.task.get(), std::move(pOwnedNode));
+
+	if (position == order.size())
+		node.orderKey = (order.empty() ? 0 : order.back()->orderKey) + ORDER_KEY_GAP;
+	else
+	{
+		if (const uint64_t previousKey = position > 0 ? order.at(position - 1)->orderKey : 0;
+			order.at(position)->orderKey - previousKey < 2)
+			RelabelOrderKeys();
+		const uint64_t previousKey = position > 0 ? order.at(position - 1)->orderKey : 0;
+		node.orderKey = previousKey + (order.at(position)->orderKey - previousKey) / 2;
+	}
+	order.insert(order.begin() + static_cast<std::ptrdiff_t>(position), &node);
+	tasksChanged = true;
+
+	const std::vector<Meta::CResourceAccessInfo>& resources = node.task->GetResourceAccessInfos();
+	for (const Meta::CResourceAccessInfo& resource : resources)
+	{
+		CClassAccesses& classAccesses = classes[resource.classHashCode];
+		if (resource.objectLevel)
+		{
+			if (std::ranges::find(classAccesses.objectTasks, &node) == classAccesses.objectTasks.end())
+				classAccesses.objectTasks.push_back(&node);
+			continue;
+		}
+		// a member accessed for the first time is implied by the object accesses of its class
+		if (++classAccesses.members[resource.hashCode] == 1)
+			for (CNode* pObjectTask : classAccesses.objectTasks)
+				if (pObjectTask != &node)
+					RefreshAccess(resource.hashCode, *pObjectTask);
+	}
+
+	for (const Meta::CResourceAccessInfo& resource : resources)
+	{
+		RefreshAccess(resource.hashCode, node);
+		chains.at(resource.hashCode).resource = resource;
+		if (resource.objectLevel)
+			for (auto&& [member, numTasks] : classes.at(resource.classHashCode).members)
+				RefreshAccess(member, node);
+	}
+
+	assert((!verification || Verify()) && "The updated graph differs from a full rebuild.");
+}
+
+bool CIncrementalTaskGraph::Remove(const ITask& task)
+{
+	const auto nodeIt = nodes.find(&task);
+	if (nodeIt == nodes.end())
+		return false;
+	CNode& node = *nodeIt->second;
+
+	// the own accesses first, so they are not refreshed again below
+	while (!node.chainResources.empty())
+		SetAccess(node.chainResources.back(), node, std::nullopt);
+
+	for (const Meta::CResourceAccessInfo& resource : node.task->GetResourceAccessInfos())
+	{
+		const auto classIt = classes.find(resource.classHashCode);
+		CClassAccesses& classAccesses = classIt->second;
+		if (resource.objectLevel)
+			std::erase(classAccesses.objectTasks, &node);
+		else if (--classAccesses.members.at(resource.hashCode) == 0)
+		{
+			// no longer implied by the object accesses of its class
+			classAccesses.members.erase(resource.hashCode);
+			for (CNode* pObjectTask : classAccesses.objectTasks)
+				if (pObjectTask != &node)
+					RefreshAccess(resource.hashCode, *pObjectTask);
+		}
+		if (classAccesses.members.empty() && classAccesses.objectTasks.empty())
+			classes.erase(classIt);
+	}
+	assert(node.parents.empty() && node.children.empty() && "Edges left without accesses.");
+
+	const auto orderIt = std::ranges::lower_bound(order, node.orderKey, {}, [](const CNode* p_node)
+	{
+		return p_node->orderKey;
+	});
+	order.erase(orderIt);
+	nodes.erase(nodeIt);
+	tasksChanged = true;
+
+	assert((!verification || Verify()) && "The updated graph differs from a full rebuild.");
+	return true;
+}
+
+const std::vector<std::shared_ptr<ITask>>& CIncrementalTaskGraph::GetTasks() const
+{
+	RefreshTasks();
+	return tasks;
+}
+
+const std::vector<std::vector<size_t>>& CIncrementalTaskGraph::GetParents() const
+{
+	RefreshTasks();
+	return parents;
+}
+
+const std::vector<std::vector<size_t>>& CIncrementalTaskGraph::GetChildren() const
+{
+	RefreshTasks();
+	return children;
+}
+
+bool CIncrementalTaskGraph::Verify() const
+{
+	const std::vector<std::shared_ptr<ITask>>& taskList = GetTasks();
+	entt::flow builder{};
+	const CResourceHierarchy resourceHierarchy(taskList);
+	for (auto&& task : taskList)
+	{
+		task->AddTaskToBuilder(builder);
+		resourceHierarchy.RegisterImpliedResources(builder, task->GetResourceAccessInfos());
+	}
+	const entt::adjacency_matrix<entt::directed_tag> graph = builder.graph();
+	if (graph.size() != taskList.size())
+		return false;
+
+	// the rebuilt graph has no transitive edges, so only the orders can be compared
+	std::vector<std::vector<size_t>> rebuiltChildren(graph.size());
+	for (size_t taskVertex = 0; taskVertex < graph.size(); ++taskVertex)
+		for (auto&& [parent, child] : graph.out_edges(taskVertex))
+			rebuiltChildren.at(taskVertex).push_back(child);
+	return ComputeReachability(rebuiltChildren) == ComputeReachability(GetChildren());
+}
+
+std::optional<bool> CIncrementalTaskGraph::GetAccess(const CNode& node, const size_t resource) const
+{
+	const std::vector<Meta::CResourceAccessInfo>& resources = node.task->GetResourceAccessInfos();
+	for (const Meta::CResourceAccessInfo& own : resources)
+		if (own.hashCode == resource)
+			return own.accessMode == Meta::EResourceAccessMode::WRITE;
+
+	// implied by an access to a whole object, written if any of them is a write
+	std::optional<bool> write;
+	for (const Meta::CResourceAccessInfo& own : resources)
+	{
+		if (!own.objectLevel)
+			continue;
+		const auto classIt = classes.find(own.classHashCode);
+		if (classIt != classes.end() && classIt->second.members.contains(resource))
+			write = write.value_or(false) || own.accessMode == Meta::EResourceAccessMode::WRITE;
+	}
+	return write;
+}
+
+void CIncrementalTaskGraph::SetAccess(const size_t resource, CNode& node, const std::optional<bool> write)
+{
+	auto chainIt = chains.find(resource);
+	if (chainIt == chains.end())
+	{
+		if (!write)
+			return;
+		chainIt = chains.try_emplace(resource).first;
+	}
+	std::vector<CAccess>& chain = chainIt->second.accesses;
+	const auto accessIt = std::ranges::lower_bound(chain, node.orderKey, {}, [](const CAccess& access)
+	{
+		return access.pNode->orderKey;
+	});
+	const bool exists = accessIt != chain.end() && accessIt->pNode == &node;
+	if ((!exists && !write) || (exists && write && accessIt->write == *write))
+		return;
+
+	// the edges only change between the writers before and after the access
+	const size_t accessIdx = static_cast<size_t>(accessIt - chain.begin());
+	size_t first = accessIdx;
+	while (first > 0 && !chain.at(first - 1).write)
+		--first;
+	if (first > 0)
+		--first;
+	size_t last = exists ? accessIdx + 1 : accessIdx;
+	while (last < chain.size() && !chain.at(last).write)
+		++last;
+	if (last < chain.size())
+		++last;
+
+	std::vector<std::pair<CNode*, CNode*>> oldEdges;
+	CollectEdges(chain, first, last, oldEdges);
+	if (!write)
+	{
+		chain.erase(accessIt);
+		--last;
+		std::erase(node.chainResources, resource);
+	}
+	else if (exists)
+		accessIt->write = *write;
+	else
+	{
+		chain.insert(accessIt, {&node, *write});
+		++last;
+		node.chainResources.push_back(resource);
+	}
+	std::vector<std::pair<CNode*, CNode*>> newEdges;
+	CollectEdges(chain, first, last, newEdges);
+	chainIt->second.numEdges = chainIt->second.numEdges + newEdges.size() - oldEdges.size();
+	if (chain.empty())
+		chains.erase(chainIt);
+
+	// only the difference, a writer may have many readers
+	std::ranges::sort(oldEdges);
+	std::ranges::sort(newEdges);
+	std::vector<std::pair<CNode*, CNode*>> changedEdges;
+	std::ranges::set_difference(oldEdges, newEdges, std::back_inserter(changedEdges));
+	for (auto&& [pParent, pChild] : changedEdges)
+		RemoveEdge(*pParent, *pChild);
+	changedEdges.clear();
+	std::ranges::set_difference(newEdges, oldEdges, std::back_inserter(changedEdges));
+	for (auto&& [pParent, pChild] : changedEdges)
+		AddEdge(*pParent, *pChild);
+}
+
+void CIncrementalTaskGraph::CollectEdges(const std::vector<CAccess>& chain, const size_t first, const size_t last,
+                                         std::vector<std::pair<CNode*, CNode*>>& edges)
+{
+	// same edges as entt::flow: a writer waits for the readers since the last writer, or for the last writer,
+	// a reader waits for the last writer
+	const CAccess* pWriter = nullptr;
+	size_t firstReader = first;
+	for (size_t idx = first; idx < last; ++idx)
+	{
+		const CAccess& access = chain.at(idx);
+		if (!access.write)
+		{
+			if (pWriter)
+				edges.emplace_back(pWriter->pNode, access.pNode);
+			continue;
+		}
+
+		if (firstReader < idx)
+			for (size_t readerIdx = firstReader; readerIdx < idx; ++readerIdx)
+				edges.emplace_back(chain.at(readerIdx).pNode, access.pNode);
+		else if (pWriter)
+			edges.emplace_back(pWriter->pNode, access.pNode);
+		pWriter = &access;
+		firstReader = idx + 1;
+	}
+}
+
+void CIncrementalTaskGraph::AddEdge(CNode& parent, CNode& child)
+{
+	const auto childIt = std::ranges::find(parent.children, &child, &CEdge::pNode);
+	if (childIt != parent.children.end())
+	{
+		++childIt->numResources;
+		++std::ranges::find(child.parents, &parent, &CEdge::pNode)->numResources;
+		return;
+	}
+	parent.children.push_back({&child, 1});
+	child.parents.push_back({&parent, 1});
+	++numEdges;
+	tasksChanged = true;
+}
+
+void CIncrementalTaskGraph::RemoveEdge(CNode& parent, CNode& child)
+{
+	auto removeFrom = [](std::vector<CEdge>& edges, const CNode* p_node)
+	{
+		const auto edgeIt = std::ranges::find(edges, p_node, &CEdge::pNode);
+		if (--edgeIt->numResources > 0)
+			return false;
+		*edgeIt = edges.back();
+		edges.pop_back();
+		return true;
+	};
+	removeFrom(child.parents, &parent);
+	if (removeFrom(parent.children, &child))
+	{
+		--numEdges;
+		tasksChanged = true;
+	}
+}
+
+void CIncrementalTaskGraph::RelabelOrderKeys()
+{
+	uint64_t orderKey = 0;
+	for (CNode* pNode : order)
+		pNode->orderKey = orderKey += ORDER_KEY_GAP;
+}
+
+void CIncrementalTaskGraph::RefreshTasks() const
+{
+	if (!tasksChanged)
+		return;
+	tasks.clear();
+	tasks.reserve(order.size());
+	for (size_t idx = 0; idx < order.size(); ++idx)
+	{
+		order.at(idx)->index = idx;
+		tasks.push_back(order.at(idx)->task);
+	}
+
+	parents.assign(order.size(), {});
+	children.assign(order.size(), {});
+	for (size_t idx = 0; idx < order.size(); ++idx)
+	{
+		for (const CEdge& parent : order.at(idx)->parents)
+			parents.at(idx).push_back(parent.pNode->index);
+		for (const CEdge& child : order.at(idx)->children)
+			children.at(idx).push_back(child.pNode->index);
+		std::ranges::sort(parents.at(idx));
+		std::ranges::sort(children.at(idx));
+	}
+	tasksChanged = false;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <MetaResourceInfo.hpp>
+
+#include "Task.hpp"
+
+/**
+ * \brief Task graph kept across frames, which is only updated by the tasks inserted or removed between them,
+ *        instead of building the whole graph of every batch (see CTaskScheduler::OrderAndExecuteTasks).
+ *        Every resource keeps the tasks accessing it in task order, an update only touches the accesses
+ *        between the writers before and after the task in the chains of its resources.
+ *        Accesses to whole objects are expanded to the members accessed in the graph, like CResourceHierarchy does.
+ *        The edges are the direct edges of the resource chains, entt::flow additionally removes the transitive ones,
+ *        both order the tasks the same way (see Verify).
+ *        Not thread-safe, the graph must not be updated while a batch of it is executed.
+ */
+class CIncrementalTaskGraph
+{
+public:
+	// appends a task behind all others
+	static constexpr size_t END = static_cast<size_t>(-1);
+
+	CIncrementalTaskGraph() = default;
+	~CIncrementalTaskGraph() = default;
+
+	CIncrementalTaskGraph(const CIncrementalTaskGraph&) = delete;
+	CIncrementalTaskGraph& operator=(const CIncrementalTaskGraph&) = delete;
+
+	/**
+	 * \brief Inserts the task in front of the task at the position, conflicting tasks are executed in task order.
+	 * \param task Task which is not part of the graph yet
+	 * \param position Index of the task in the graph, END or any larger index appends it
+	 */
+	void Insert(std::shared_ptr<ITask> task, size_t position = END);
+	// removes the task, false if it is not part of the graph
+	bool Remove(const ITask& task);
+	bool Contains(const ITask& task) const { return nodes.contains(&task); }
+
+	size_t GetNumTasks() const { return order.size(); }
+	// number of distinct edges, an edge created by several resources counts once
+	size_t GetNumEdges() const { return numEdges; }
+
+	// the tasks in task order, refreshed after an update on the first call
+	const std::vector<std::shared_ptr<ITask>>& GetTasks() const;
+	// indices of the parents of every task in GetTasks, ascending
+	const std::vector<std::vector<size_t>>& GetParents() const;
+	// indices of the children of every task in GetTasks, ascending
+	const std::vector<std::vector<size_t>>& GetChildren() const;
+
+	/**
+	 * \brief Calls the visitor with every resource creating edges and its number of edges.
+	 * \param visitor Called as visitor(const Meta::CResourceAccessInfo& resource, size_t num_edges)
+	 */
+	template <typename Visitor>
+	void VisitResourceEdges(Visitor&& visitor) const;
+
+	/**
+	 * \brief Rebuilds the graph of the tasks with entt::flow and compares the orders of both graphs.
+	 *        Expensive, for tests and debugging.
+	 * \return true if a task waits for another one in the rebuilt graph exactly if it does in this one
+	 */
+	bool Verify() const;
+	// verifies the graph after every update in debug builds, see Verify
+	void SetVerification(const bool verify) { verification = verify; }
+
+private:
+	// gap between the order keys of neighbor tasks after relabeling them
+	static constexpr uint64_t ORDER_KEY_GAP = uint64_t{1} << 32;
+
+	struct CNode;
+
+	// task with the number of resources creating the edge to it
+	struct CEdge
+	{
+		CNode* pNode = nullptr;
+		size_t numResources = 0;
+	};
+
+	struct CNode
+	{
+		std::shared_ptr<ITask> task;
+		// ascending in task order, gaps leave room for inserting tasks without renumbering the others
+		uint64_t orderKey = 0;
+		// resources with an access of the task in their chain, own and implied ones
+		std::vector<size_t> chainResources;
+		std::vector<CEdge> parents;
+		std::vector<CEdge> children;
+		// index in the refreshed task list
+		size_t index = 0;
+	};
+
+	// access of a task to a resource, the own access or the strongest implied one
+	struct CAccess
+	{
+		CNode* pNode = nullptr;
+		bool write = false;
+	};
+
+	struct CChain
+	{
+		// own access of a task to the resource, describes the resource
+		Meta::CResourceAccessInfo resource;
+		// in task order
+		std::vector<CAccess> accesses;
+		size_t numEdges = 0;
+	};
+
+	struct CClassAccesses
+	{
+		// members accessed in the graph with the number of tasks accessing them
+		std::unordered_map<size_t, size_t> members;
+		// tasks accessing an object of the class as a whole
+		std::vector<CNode*> objectTasks;
+	};
+
+	std::unordered_map<const ITask*, std::unique_ptr<CNode>> nodes;
+	std::vector<CNode*> order;
+	std::unordered_map<size_t, CChain> chains;
+	std::unordered_map<size_t, CClassAccesses> classes;
+	size_t numEdges = 0;
+	bool verification = false;
+
+	// refreshed on demand after an update
+	mutable bool tasksChanged = false;
+	mutable std::vector<std::shared_ptr<ITask>> tasks;
+	mutable std::vector<std::vector<size_t>> parents;
+	mutable std::vector<std::vector<size_t>> children;
+
+	// access of the task to the resource in a full rebuild, empty if it does not access it
+	std::optional<bool> GetAccess(const CNode& node, size_t resource) const;
+	// sets the access of the task in the chain of the resource and updates the edges between the writers around it
+	void SetAccess(size_t resource, CNode& node, std::optional<bool> write);
+	void RefreshAccess(size_t resource, CNode& node) { SetAccess(resource, node, GetAccess(node, resource)); }
+	// appends the edges between the accesses of the chain in [first, last) as parent and child
+	static void CollectEdges(const std::vector<CAccess>& chain, size_t first, size_t last,
+	                         std::vector<std::pair<CNode*, CNode*>>& edges);
+	void AddEdge(CNode& parent, CNode& child);
+	void RemoveEdge(CNode& parent, CNode& child);
+	// spreads the order keys evenly again
+	void RelabelOrderKeys();
+	void RefreshTasks() const;
+};
+
+template <typename Visitor>
+void CIncrementalTaskGraph::VisitResourceEdges(Visitor&& visitor) const
+{
+	for (auto&& [resourceHashCode, chain] : chains)
+		if (chain.numEdges > 0)
+			visitor(chain.resource, chain.numEdges);
+}
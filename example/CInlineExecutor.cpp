@@ -0,0 +1,42 @@
+#include "CInlineExecutor.h"
+
+#include <numeric>
+
+void CInlineExecutor::Enqueue(TJob&& job, const ETaskLane lane)
+{
+	std::scoped_lock lock(mutex);
+	jobs.at(static_cast<size_t>(lane)).push_back(std::move(job));
+	// notify while holding the lock, so a thread outside of the executor (e.g. a timer resuming a task)
+	// is done with it before the job can run and the executor can be destroyed
+	NotifyHelpers();
+}
+
+bool CInlineExecutor::RunPendingJob()
+{
+	TJob job;
+	{
+		std::scoped_lock lock(mutex);
+		for (std::deque<TJob>& laneJobs : jobs)
+			if (!laneJobs.empty())
+			{
+				job = std::move(laneJobs.front());
+				laneJobs.pop_front();
+				break;
+			}
+	}
+	if (!job)
+		return false;
+	// not locked, the job may enqueue further jobs
+	job();
+	NotifyHelpers();
+	return true;
+}
+
+size_t CInlineExecutor::GetNumPendingJobs() const
+{
+	std::scoped_lock lock(mutex);
+	return std::accumulate(jobs.begin(), jobs.end(), size_t{0}, [](const size_t sum, const std::deque<TJob>& lane_jobs)
+	{
+		return sum + lane_jobs.size();
+	});
+}
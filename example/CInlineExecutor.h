@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <mutex>
+
+#include "ITaskExecutor.h"
+
+/**
+ * \brief Executor without threads of its own: jobs only run on the threads waiting for them (see HelpUntil),
+ *        one after another in lane order and, within a lane, in the order they were enqueued.
+ *        Waiting on a single thread, a batch is executed the same way every time, which makes tests reproducible.
+ */
+class CInlineExecutor final : public ITaskExecutor
+{
+public:
+	CInlineExecutor() = default;
+	~CInlineExecutor() override = default;
+
+	CInlineExecutor(const CInlineExecutor&) = delete;
+	CInlineExecutor& operator=(const CInlineExecutor&) = delete;
+
+	void Enqueue(TJob&& job, ETaskLane lane = ETaskLane::NORMAL) override;
+	bool RunPendingJob() override;
+
+	size_t GetNumWorkers() const override { return 1; }
+	size_t GetNumPendingJobs() const override;
+	// nothing executes the jobs unless the waiting thread does
+	bool IsWorkerThread() const override { return true; }
+
+private:
+	static constexpr size_t NUM_LANES = static_cast<size_t>(ETaskLane::BACKGROUND) + 1;
+
+	mutable std::mutex mutex;
+	std::array<std::deque<TJob>, NUM_LANES> jobs;
+};
@@ -0,0 +1,133 @@
+#include "CResourceContention.h"
+
+#include <algorithm>
+#include <bit>
+
+CResourceContention::CResourceContention(const ITaskExecutor& executor, const size_t num_slots)
+	: executor(executor)
+	, numSlots(std::bit_ceil(std::max<size_t>(num_slots, 2)))
+{
+	// the last shard is shared by the threads which are not workers
+	const size_t numShards = executor.GetNumWorkers() + 1;
+	shards.reserve(numShards);
+	for (size_t shard = 0; shard < numShards; ++shard)
+		shards.push_back(std::make_unique<CSlot[]>(numSlots));
+	usedSlots.resize(numShards);
+}
+
+void CResourceContention::BeginFrame()
+{
+	// the frame before the last one had the same parity
+	const size_t frame = countedFrame.load() + 1;
+	const size_t parity = frame % 2;
+	{
+		// the other slots were never counted into
+		std::scoped_lock lock(namesMutex);
+		for (size_t shard = 0; shard < shards.size(); ++shard)
+			for (const size_t slot : usedSlots.at(shard))
+			{
+				shards.at(shard)[slot].numEdges.at(parity).store(0, std::memory_order_relaxed);
+				shards.at(shard)[slot].starvedNs.at(parity).store(0, std::memory_order_relaxed);
+			}
+	}
+	countedFrame.store(frame);
+}
+
+void CResourceContention::EndFrame()
+{
+	lastFrame.store(countedFrame.load());
+}
+
+void CResourceContention::AddEdges(const Meta::CResourceAccessInfo& resource, const size_t num_edges)
+{
+	if (CSlot* pSlot = GetSlot(resource))
+		pSlot->numEdges.at(countedFrame.load(std::memory_order_relaxed) % 2).fetch_add(num_edges, std::memory_order_relaxed);
+}
+
+void CResourceContention::AddStarvedTime(const Meta::CResourceAccessInfo& resource, const TCost starved_time)
+{
+	if (CSlot* pSlot = GetSlot(resource))
+		pSlot->starvedNs.at(countedFrame.load(std::memory_order_relaxed) % 2).fetch_add(
+			static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(starved_time).count()),
+			std::memory_order_relaxed);
+}
+
+std::vector<CResourceContention::CResourceCounters> CResourceContention::GetSnapshot() const
+{
+	const size_t frame = lastFrame.load();
+	if (frame == NO_FRAME)
+		return {};
+	const size_t parity = frame % 2;
+
+	std::unordered_map<size_t, CResourceCounters> counters;
+	for (auto&& shard : shards)
+		for (size_t slot = 0; slot < numSlots; ++slot)
+		{
+			const size_t resourceHashCode = shard[slot].resourceHashCode.load(std::memory_order_acquire);
+			const uint64_t numEdges = shard[slot].numEdges.at(parity).load(std::memory_order_relaxed);
+			const uint64_t starvedNs = shard[slot].starvedNs.at(parity).load(std::memory_order_relaxed);
+			if (resourceHashCode == 0 || (numEdges == 0 && starvedNs == 0))
+				continue;
+			CResourceCounters& resourceCounters = counters[resourceHashCode];
+			resourceCounters.resourceHashCode = resourceHashCode;
+			resourceCounters.numEdges += numEdges;
+			resourceCounters.starvedTime += std::chrono::duration_cast<TCost>(std::chrono::nanoseconds(starvedNs));
+		}
+
+	std::vector<CResourceCounters> snapshot;
+	snapshot.reserve(counters.size());
+	{
+		std::scoped_lock lock(namesMutex);
+		for (auto&& [resourceHashCode, resourceCounters] : counters)
+		{
+			if (const auto name = names.find(resourceHashCode); name != names.end())
+			{
+				resourceCounters.className = name->second.className;
+				resourceCounters.memberName = name->second.memberName;
+			}
+			snapshot.push_back(resourceCounters);
+		}
+	}
+	std::ranges::sort(snapshot, [](const CResourceCounters& a, const CResourceCounters& b)
+	{
+		if (a.starvedTime != b.starvedTime)
+			return a.starvedTime > b.starvedTime;
+		return a.numEdges > b.numEdges;
+	});
+	return snapshot;
+}
+
+CResourceContention::CSlot* CResourceContention::GetSlot(const Meta::CResourceAccessInfo& resource)
+{
+	const size_t resourceHashCode = resource.hashCode;
+	if (resourceHashCode == 0)
+		return nullptr;
+
+	const size_t workerIdx = executor.GetCurrentWorker();
+	const size_t shard = workerIdx < shards.size() - 1 ? workerIdx : shards.size() - 1;
+	CSlot* pShard = shards.at(shard).get();
+	const size_t firstSlot = Meta::GetResourceSlot(resourceHashCode, numSlots);
+	for (size_t probe = 0; probe < std::min(numSlots, MAX_PROBES); ++probe)
+	{
+		const size_t slotIdx = (firstSlot + probe) & (numSlots - 1);
+		CSlot& slot = pShard[slotIdx];
+		size_t slotHashCode = slot.resourceHashCode.load(std::memory_order_acquire);
+		if (slotHashCode == resourceHashCode)
+			return &slot;
+		if (slotHashCode != 0)
+			continue;
+
+		// another thread sharing the last shard may take the slot first
+		if (slot.resourceHashCode.compare_exchange_strong(slotHashCode, resourceHashCode))
+		{
+			std::scoped_lock lock(namesMutex);
+			names.try_emplace(resourceHashCode, CResourceName{resource.className, resource.memberName});
+			usedSlots.at(shard).push_back(slotIdx);
+			return &slot;
+		}
+		if (slotHashCode == resourceHashCode)
+			return &slot;
+	}
+	numDroppedCounts.fetch_add(1, std::memory_order_relaxed);
+	return nullptr;
+}
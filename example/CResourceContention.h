@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <MetaResourceInfo.hpp>
+
+#include "ITaskExecutor.h"
+#include "Task.hpp"
+
+/**
+ * \brief Counters of the serialization every resource causes, cheap enough to find the bottleneck of a running system
+ *        without a profiler: the dependency edges each resource created and the worker time spent
+ *        without a ready task while a task accessing the resource was running.
+ *        Every worker of the executor counts into its own shard, an open-addressing table of atomic counters,
+ *        so counting never takes a lock once a resource was seen by the worker.
+ *        All other threads share one more shard.
+ *        The counters of the last frame are kept while the next one is counted,
+ *        a new frame only clears the slots of the resources seen so far.
+ */
+class CResourceContention
+{
+public:
+	using TCost = ITask::TCost;
+
+	static constexpr size_t DEFAULT_NUM_SLOTS = 1024;
+	// a resource is only looked for in this many slots from its first one, so a full shard is never searched through
+	static constexpr size_t MAX_PROBES = 32;
+
+	struct CResourceCounters
+	{
+		size_t resourceHashCode = 0;
+		std::string_view className;
+		std::string_view memberName;
+		// dependency edges created by the accesses to the resource, before removing transitive ones
+		size_t numEdges = 0;
+		// worker time spent without a ready task while a task accessing the resource was running
+		TCost starvedTime = TCost::zero();
+	};
+
+	/**
+	 * \param executor Executor whose workers count, has to outlive the counters
+	 * \param num_slots Number of resources per shard, rounded up to a power of two
+	 */
+	explicit CResourceContention(const ITaskExecutor& executor, size_t num_slots = DEFAULT_NUM_SLOTS);
+	~CResourceContention() = default;
+
+	CResourceContention(const CResourceContention&) = delete;
+	CResourceContention& operator=(const CResourceContention&) = delete;
+
+	// clears the counters of the frame before the last one and counts into them from now on
+	void BeginFrame();
+	// the counted frame becomes the last frame of the snapshots
+	void EndFrame();
+
+	// counts into the shard of the calling worker, from any thread
+	void AddEdges(const Meta::CResourceAccessInfo& resource, size_t num_edges);
+	void AddStarvedTime(const Meta::CResourceAccessInfo& resource, TCost starved_time);
+
+	/**
+	 * \brief Sums up the counters of the last frame over all shards, from any thread.
+	 *        Taken while the next frame begins, a snapshot may mix both frames.
+	 * \return The resources which created edges or starved workers, the most starved time first
+	 */
+	std::vector<CResourceCounters> GetSnapshot() const;
+
+	// counts dropped, since the slots of the resource in the shard of the counting thread were taken
+	size_t GetNumDroppedCounts() const { return numDroppedCounts.load(std::memory_order_relaxed); }
+
+private:
+	static constexpr size_t NO_FRAME = static_cast<size_t>(-1);
+
+	struct CSlot
+	{
+		// zero marks an empty slot
+		std::atomic<size_t> resourceHashCode = 0;
+		// counters of two frames, indexed by the parity of the frame
+		std::array<std::atomic<uint64_t>, 2> numEdges{};
+		std::array<std::atomic<uint64_t>, 2> starvedNs{};
+	};
+
+	struct CResourceName
+	{
+		std::string_view className;
+		std::string_view memberName;
+	};
+
+	const ITaskExecutor& executor;
+	const size_t numSlots;
+	std::vector<std::unique_ptr<CSlot[]>> shards;
+	std::atomic<size_t> countedFrame = 0;
+	std::atomic<size_t> lastFrame = NO_FRAME;
+	std::atomic<size_t> numDroppedCounts = 0;
+	// names of the seen resources, only locked when a thread sees a resource for the first time
+	mutable std::mutex namesMutex;
+	std::unordered_map<size_t, CResourceName> names;
+	// taken slots per shard, cleared by a new frame, guarded by the names mutex
+	std::vector<std::vector<size_t>> usedSlots;
+
+	// slot of the resource in the shard of the calling worker, nullptr if the shard is full
+	CSlot* GetSlot(const Meta::CResourceAccessInfo& resource);
+};
@@ -0,0 +1,49 @@
+#include "CResourceHierarchy.h"
+
+#include <algorithm>
+
+CResourceHierarchy::CResourceHierarchy(const std::vector<std::shared_ptr<ITask>>& task_list)
+{
+	for (auto&& task : task_list)
+		for (const Meta::CResourceAccessInfo& resource : task->GetResourceAccessInfos())
+			if (resource.objectLevel)
+			{
+				objectClasses.Add(resource.classHashCode);
+				accessedMembers.try_emplace(resource.classHashCode);
+			}
+	if (accessedMembers.empty())
+		return;
+
+	for (auto&& task : task_list)
+		for (const Meta::CResourceAccessInfo& resource : task->GetResourceAccessInfos())
+		{
+			// member granularity only for the classes in the summary
+			if (resource.objectLevel || !objectClasses.MayContain(resource.classHashCode))
+				continue;
+			const auto members = accessedMembers.find(resource.classHashCode);
+			if (members != accessedMembers.end() && std::ranges::find(members->second, resource.hashCode) == members->second.end())
+				members->second.push_back(resource.hashCode);
+		}
+}
+
+void CResourceHierarchy::RegisterImpliedResources(entt::flow& builder,
+                                                  const std::vector<Meta::CResourceAccessInfo>& resources,
+                                                  const size_t ignored_resource) const
+{
+	VisitImpliedResources(resources, [&builder](const size_t member, const Meta::EResourceAccessMode access_mode)
+	{
+		if (access_mode == Meta::EResourceAccessMode::WRITE)
+			builder.rw(member);
+		else
+			builder.ro(member);
+	}, ignored_resource);
+}
+
+const std::vector<size_t>& CResourceHierarchy::GetAccessedMembers(const size_t class_hash_code) const
+{
+	static const std::vector<size_t> noMembers;
+	if (!objectClasses.MayContain(class_hash_code))
+		return noMembers;
+	const auto members = accessedMembers.find(class_hash_code);
+	return members != accessedMembers.end() ? members->second : noMembers;
+}
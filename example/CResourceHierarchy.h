@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <MetaResourceInfo.hpp>
+
+#include "Task.hpp"
+
+/**
+ * \brief Expands the accesses to whole objects (see Meta::CObjectResourceAccess) of a batch for the graph builder,
+ *        which only orders accesses to the same resource.
+ *        An object access is registered for the object and for every member of its class accessed in the batch,
+ *        so it is ordered against all of them, while accesses to different members stay independent.
+ *        Classes are looked up in a summary first, so batches without object accesses only cost one bit test per resource.
+ */
+class CResourceHierarchy
+{
+public:
+	explicit CResourceHierarchy(const std::vector<std::shared_ptr<ITask>>& task_list);
+	~CResourceHierarchy() = default;
+
+	/**
+	 * \brief Registers the members implied by the object accesses of the task for the vertex currently bound to the builder.
+	 *        The own resources of the task have to be registered by the caller.
+	 * \param builder The graph builder
+	 * \param resources Filtered resources of a task of the batch
+	 * \param ignored_resource Accesses to this resource are not expanded, zero expands all of them
+	 */
+	void RegisterImpliedResources(entt::flow& builder, const std::vector<Meta::CResourceAccessInfo>& resources,
+	                              size_t ignored_resource = 0) const;
+
+	/**
+	 * \brief Calls the visitor with the hash code and access mode of every member implied by the object accesses of the task,
+	 *        except for the own resources of the task.
+	 * \param resources Filtered resources of a task of the batch
+	 * \param visitor Called as visitor(size_t hash_code, Meta::EResourceAccessMode access_mode)
+	 * \param ignored_resource Accesses to this resource are not expanded, zero expands all of them
+	 */
+	template <typename Visitor>
+	void VisitImpliedResources(const std::vector<Meta::CResourceAccessInfo>& resources, Visitor&& visitor,
+	                           size_t ignored_resource = 0) const;
+
+	// members of the class accessed in the batch, empty if the class is never accessed as a whole object
+	const std::vector<size_t>& GetAccessedMembers(size_t class_hash_code) const;
+
+private:
+	// classes accessed as a whole object
+	Meta::CClassSummary objectClasses;
+	// accessed members of every class accessed as a whole object
+	std::unordered_map<size_t, std::vector<size_t>> accessedMembers;
+};
+
+template <typename Visitor>
+void CResourceHierarchy::VisitImpliedResources(const std::vector<Meta::CResourceAccessInfo>& resources, Visitor&& visitor,
+                                               const size_t ignored_resource) const
+{
+	for (const Meta::CResourceAccessInfo& resource : resources)
+	{
+		if (!resource.objectLevel || resource.hashCode == ignored_resource)
+			continue;
+		for (const size_t member : GetAccessedMembers(resource.classHashCode))
+		{
+			// the resources are filtered, so a member accessed next to its object is written while the object is read
+			const bool ownMember = std::ranges::any_of(resources, [member](const Meta::CResourceAccessInfo& own)
+			{
+				return own.hashCode == member;
+			});
+			if (!ownMember && member != ignored_resource)
+				visitor(member, resource.accessMode);
+		}
+	}
+}
@@ -0,0 +1,87 @@
+#include "CResourceLockTable.h"
+
+#include <algorithm>
+#include <bit>
+
+CResourceLockTable::CResourceLockTable(const size_t num_stripes)
+	: stripes(std::bit_ceil(std::max<size_t>(num_stripes, 2)))
+{
+}
+
+CResourceLockTable::TLockSet CResourceLockTable::MakeLockSet(const std::vector<Meta::CResourceAccessInfo>& resources)
+{
+	TLockSet lockSet;
+	lockSet.reserve(resources.size());
+	for (const Meta::CResourceAccessInfo& resource : resources)
+		lockSet.push_back({Meta::GetResourceSlot(resource.hashCode, stripes.size()), resource.accessMode == Meta::EResourceAccessMode::WRITE});
+	std::ranges::sort(lockSet, [](const CLock& a, const CLock& b) { return a.stripe < b.stripe; });
+
+	// merge the locks of the same stripe
+	TLockSet mergedSet;
+	for (const CLock& lock : lockSet)
+	{
+		if (!mergedSet.empty() && mergedSet.back().stripe == lock.stripe)
+			mergedSet.back().exclusive = mergedSet.back().exclusive || lock.exclusive;
+		else
+			mergedSet.push_back(lock);
+	}
+
+	// one ticket per stripe, a read joins the reads in front of it
+	for (CLock& lock : mergedSet)
+	{
+		CStripe& stripe = stripes.at(lock.stripe);
+		const std::uint64_t ticket = stripe.numTickets++;
+		if (lock.exclusive || !stripe.lastShared)
+			stripe.sharedTurn = ticket;
+		lock.turn = lock.exclusive ? ticket : stripe.sharedTurn;
+		stripe.lastShared = !lock.exclusive;
+	}
+	return mergedSet;
+}
+
+bool CResourceLockTable::LockOrWait(const TLockSet& lock_set, const size_t waiter)
+{
+	// once the tickets before the turn were released, no conflicting task holds the stripe,
+	// and all later conflicting tickets wait for this one, so a stripe stays available while the next ones are checked
+	for (const CLock& lock : lock_set)
+	{
+		CStripe& stripe = stripes.at(lock.stripe);
+		if (stripe.numReleased.load() >= lock.turn)
+			continue;
+
+		std::scoped_lock waitLock(waitMutex);
+		// counted before checking again, so an unlock meanwhile either hands back the waiter,
+		// or released the turn before the second check
+		stripe.numWaiters.fetch_add(1);
+		if (stripe.numReleased.load() >= lock.turn)
+		{
+			stripe.numWaiters.fetch_sub(1);
+			continue;
+		}
+		stripe.waiters.push_back({lock.turn, waiter});
+		return false;
+	}
+	return true;
+}
+
+void CResourceLockTable::Unlock(const TLockSet& lock_set, std::vector<size_t>& woken_waiters)
+{
+	for (const CLock& lock : lock_set)
+	{
+		CStripe& stripe = stripes.at(lock.stripe);
+		stripe.numReleased.fetch_add(1);
+		if (stripe.numWaiters.load() == 0)
+			continue;
+
+		std::scoped_lock waitLock(waitMutex);
+		const std::uint64_t numReleased = stripe.numReleased.load();
+		const size_t numWaiters = std::erase_if(stripe.waiters, [&](const CWaiter& parked)
+		{
+			if (parked.turn > numReleased)
+				return false;
+			woken_waiters.push_back(parked.waiter);
+			return true;
+		});
+		stripe.numWaiters.fetch_sub(numWaiters);
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <MetaResourceInfo.hpp>
+
+/**
+ * \brief Striped reader-writer locks indexed by resource hash code, for executing tasks without a graph.
+ *        Every resource maps to one stripe, resources sharing a stripe share its lock.
+ *        Reads lock a stripe shared, writes exclusively.
+ *        The locks are granted in the order the lock sets were made, like tickets:
+ *        a write waits for all earlier tickets of the stripe, a read only for the tickets before the reads in front of it,
+ *        so conflicting tasks run in the order of their lock sets, as in the graph.
+ *        The earliest unfinished lock set can always be taken, so waiting for the locks never deadlocks.
+ *        A waiting task is parked on the stripe it waits for and handed back once that stripe reached its turn.
+ *        The locks are not owned by a thread, so a task suspended on one worker may release them on another.
+ */
+class CResourceLockTable
+{
+public:
+	static constexpr size_t DEFAULT_NUM_STRIPES = 1024;
+
+	struct CLock
+	{
+		size_t stripe = 0;
+		bool exclusive = false;
+		// number of released tickets of the stripe the lock waits for
+		std::uint64_t turn = 0;
+	};
+
+	// locks of a task sorted by stripe
+	using TLockSet = std::vector<CLock>;
+
+	// the number of stripes is rounded up to a power of two
+	explicit CResourceLockTable(size_t num_stripes = DEFAULT_NUM_STRIPES);
+	~CResourceLockTable() = default;
+
+	CResourceLockTable(const CResourceLockTable&) = delete;
+	CResourceLockTable& operator=(const CResourceLockTable&) = delete;
+
+	/**
+	 * \brief Draws a ticket on every stripe of the resources, in the order the tasks shall take their locks.
+	 *        Not thread-safe, all lock sets of a batch are made before the first one is locked.
+	 * \return One lock per stripe of the resources, exclusive if any resource of the stripe is written
+	 */
+	TLockSet MakeLockSet(const std::vector<Meta::CResourceAccessInfo>& resources);
+
+	/**
+	 * \brief Takes all locks of the set, if it is the turn of all of them.
+	 *        Otherwise nothing is taken, so a waiting task never holds a lock,
+	 *        and the waiter is parked on the first stripe whose turn has not come yet.
+	 * \param waiter Handed back by the Unlock bringing the turn of the stripe, e.g. the index of the task
+	 * \return false if the waiter was parked, because a conflicting task with an earlier ticket has not released its lock yet
+	 */
+	bool LockOrWait(const TLockSet& lock_set, size_t waiter);
+
+	/**
+	 * \brief Releases the locks of the set, from any thread, every lock set is unlocked exactly once.
+	 * \param woken_waiters Gets the parked waiters whose stripe reached their turn, they have to call LockOrWait again
+	 */
+	void Unlock(const TLockSet& lock_set, std::vector<size_t>& woken_waiters);
+
+	size_t GetNumStripes() const { return stripes.size(); }
+
+private:
+	struct CWaiter
+	{
+		std::uint64_t turn = 0;
+		size_t waiter = 0;
+	};
+
+	// one cache line per stripe, so locking one stripe does not slow down the threads locking its neighbors
+	struct alignas(64) CStripe
+	{
+		std::atomic<std::uint64_t> numReleased = 0;
+		// only used while making the lock sets
+		std::uint64_t numTickets = 0;
+		// first ticket of the reads at the end of the queue, which share their turn
+		std::uint64_t sharedTurn = 0;
+		bool lastShared = false;
+		// the parked waiters, guarded by the wait mutex, which an unlock only takes if there are any
+		std::atomic<size_t> numWaiters = 0;
+		std::vector<CWaiter> waiters;
+	};
+
+	std::vector<CStripe> stripes;
+	std::mutex waitMutex;
+};
@@ -0,0 +1,215 @@
+#include "CScheduleSimulator.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
+
+// take uint64_t, so we can use 64-bit pointers as unique id in the graph builder
+#ifndef ENTT_ID_TYPE
+#define ENTT_ID_TYPE std::uint64_t
+#endif
+// defined id type before include
+#include <include/entt/src/entt/graph/flow.hpp>
+
+#include "CResourceHierarchy.h"
+
+namespace
+{
+	using TCost = CScheduleSimulator::TCost;
+
+	constexpr size_t NO_RESOURCE = 0;
+
+	struct CBatchGraph
+	{
+		std::vector<std::vector<size_t>> children;
+		std::vector<size_t> numParents;
+		std::vector<TCost> costs;
+		// priorities as used by the scheduler
+		std::vector<ETaskLane> lanes;
+		std::vector<TCost> bottomLevels;
+	};
+
+	/**
+	 * \brief Builds the execution graph like the scheduler does, optionally without the edges of one resource.
+	 */
+	CBatchGraph BuildGraph(const std::vector<std::shared_ptr<ITask>>& task_list, const size_t ignored_resource)
+	{
+		entt::flow builder{};
+		const CResourceHierarchy resourceHierarchy(task_list);
+		for (size_t taskIdx = 0; taskIdx < task_list.size(); ++taskIdx)
+		{
+			builder.bind(taskIdx);
+			for (const Meta::CResourceAccessInfo& resource : task_list.at(taskIdx)->GetResourceAccessInfos())
+			{
+				if (resource.hashCode == ignored_resource)
+					continue;
+				if (resource.accessMode == Meta::EResourceAccessMode::WRITE)
+					builder.rw(resource.hashCode);
+				else
+					builder.ro(resource.hashCode);
+			}
+			resourceHierarchy.RegisterImpliedResources(builder, task_list.at(taskIdx)->GetResourceAccessInfos(),
+			                                           ignored_resource);
+		}
+		const entt::adjacency_matrix<entt::directed_tag> graph = builder.graph();
+
+		const size_t numTasks = graph.size();
+		CBatchGraph batchGraph{
+			std::vector<std::vector<size_t>>(numTasks), std::vector<size_t>(numTasks, 0),
+			std::vector<TCost>(numTasks), std::vector<ETaskLane>(numTasks), std::vector<TCost>(numTasks)
+		};
+		for (size_t taskIdx = 0; taskIdx < numTasks; ++taskIdx)
+		{
+			for (auto&& [parent, child] : graph.out_edges(taskIdx))
+			{
+				batchGraph.children.at(taskIdx).push_back(child);
+				++batchGraph.numParents.at(child);
+			}
+			batchGraph.costs.at(taskIdx) = task_list.at(taskIdx)->GetCost().value_or(TCost::zero());
+		}
+
+		// same as the scheduler: bottom level with a minimum cost per task and the most urgent lane of all descendants,
+		// all edges point from a lower to a higher index
+		for (size_t taskIdx = numTasks; taskIdx-- > 0;)
+		{
+			TCost longestChildPath = TCost::zero();
+			ETaskLane lane = task_list.at(taskIdx)->GetLane();
+			for (const size_t child : batchGraph.children.at(taskIdx))
+			{
+				longestChildPath = std::max(longestChildPath, batchGraph.bottomLevels.at(child));
+				lane = std::min(lane, batchGraph.lanes.at(child));
+			}
+			batchGraph.bottomLevels.at(taskIdx) = std::max(batchGraph.costs.at(taskIdx), TCost(1)) + longestChildPath;
+			batchGraph.lanes.at(taskIdx) = lane;
+		}
+		return batchGraph;
+	}
+
+	// event driven list scheduling, returns the makespan
+	TCost SimulateGraph(const CBatchGraph& batch_graph, const size_t num_cores)
+	{
+		const size_t numTasks = batch_graph.costs.size();
+
+		auto hasLowerPriority = [&](const size_t task_a, const size_t task_b)
+		{
+			return std::make_tuple(batch_graph.lanes.at(task_b), batch_graph.bottomLevels.at(task_a), task_b)
+				< std::make_tuple(batch_graph.lanes.at(task_a), batch_graph.bottomLevels.at(task_b), task_a);
+		};
+		std::priority_queue<size_t, std::vector<size_t>, decltype(hasLowerPriority)> readyTasks(hasLowerPriority);
+		// finish time and task, the earliest first
+		using TRunningTask = std::pair<TCost, size_t>;
+		std::priority_queue<TRunningTask, std::vector<TRunningTask>, std::greater<>> runningTasks;
+
+		std::vector<size_t> numPendingParents = batch_graph.numParents;
+		for (size_t taskIdx = 0; taskIdx < numTasks; ++taskIdx)
+			if (numPendingParents.at(taskIdx) == 0)
+				readyTasks.push(taskIdx);
+
+		TCost time = TCost::zero();
+		while (!readyTasks.empty() || !runningTasks.empty())
+		{
+			while (!readyTasks.empty() && runningTasks.size() < num_cores)
+			{
+				const size_t taskIdx = readyTasks.top();
+				readyTasks.pop();
+				runningTasks.emplace(time + batch_graph.costs.at(taskIdx), taskIdx);
+			}
+
+			const auto [finishTime, taskIdx] = runningTasks.top();
+			runningTasks.pop();
+			time = finishTime;
+			for (const size_t child : batch_graph.children.at(taskIdx))
+				if (--numPendingParents.at(child) == 0)
+					readyTasks.push(child);
+		}
+		return time;
+	}
+
+	CScheduleSimulator::CResult MakeResult(const CBatchGraph& batch_graph, const size_t num_cores)
+	{
+		CScheduleSimulator::CResult result{
+			num_cores, SimulateGraph(batch_graph, num_cores), TCost::zero(), TCost::zero(), 1.0, 1.0
+		};
+		for (const TCost cost : batch_graph.costs)
+			result.totalWork += cost;
+		// without the minimum cost of the bottom levels, all edges point from a lower to a higher index
+		std::vector<TCost> longestPaths(batch_graph.costs.size(), TCost::zero());
+		for (size_t taskIdx = batch_graph.costs.size(); taskIdx-- > 0;)
+		{
+			for (const size_t child : batch_graph.children.at(taskIdx))
+				longestPaths.at(taskIdx) = std::max(longestPaths.at(taskIdx), longestPaths.at(child));
+			longestPaths.at(taskIdx) += batch_graph.costs.at(taskIdx);
+			result.criticalPath = std::max(result.criticalPath, longestPaths.at(taskIdx));
+		}
+		if (result.makespan > TCost::zero())
+		{
+			const auto makespan = static_cast<double>(result.makespan.count());
+			result.speedup = static_cast<double>(result.totalWork.count()) / makespan;
+			result.utilization = result.speedup / static_cast<double>(num_cores);
+		}
+		return result;
+	}
+}
+
+CScheduleSimulator::CResult CScheduleSimulator::Simulate(const std::vector<std::shared_ptr<ITask>>& task_list,
+                                                         const size_t num_cores)
+{
+	return MakeResult(BuildGraph(task_list, NO_RESOURCE), std::max<size_t>(num_cores, 1));
+}
+
+std::vector<CScheduleSimulator::CResult> CScheduleSimulator::SimulateSpeedup(
+	const std::vector<std::shared_ptr<ITask>>& task_list, const size_t max_cores)
+{
+	const CBatchGraph batchGraph = BuildGraph(task_list, NO_RESOURCE);
+	std::vector<CResult> results;
+	for (size_t numCores = 1; numCores <= max_cores; ++numCores)
+		results.push_back(MakeResult(batchGraph, numCores));
+	return results;
+}
+
+std::vector<CScheduleSimulator::CResourceIdleTime> CScheduleSimulator::ComputeResourceIdleTimes(
+	const std::vector<std::shared_ptr<ITask>>& task_list, const size_t num_cores)
+{
+	const size_t numCores = std::max<size_t>(num_cores, 1);
+	const TCost makespan = SimulateGraph(BuildGraph(task_list, NO_RESOURCE), numCores);
+
+	// every resource once, in order of appearance
+	std::vector<CResourceIdleTime> idleTimes;
+	std::unordered_map<size_t, size_t> resourceIndices;
+	for (auto&& task : task_list)
+		for (const Meta::CResourceAccessInfo& resource : task->GetResourceAccessInfos())
+			if (resourceIndices.emplace(resource.hashCode, idleTimes.size()).second)
+				idleTimes.push_back({resource.hashCode, resource.className, resource.memberName, TCost::zero()});
+
+	for (CResourceIdleTime& idleTime : idleTimes)
+	{
+		const TCost makespanWithout = SimulateGraph(BuildGraph(task_list, idleTime.resourceHashCode), numCores);
+		// list scheduling is not monotonic, removing edges may even increase the makespan
+		if (makespanWithout < makespan)
+			idleTime.idleTime = (makespan - makespanWithout) * static_cast<TCost::rep>(numCores);
+	}
+
+	std::ranges::stable_sort(idleTimes, std::greater<>{}, &CResourceIdleTime::idleTime);
+	return idleTimes;
+}
+
+void CScheduleSimulator::PrintReport(std::ostream& stream, const std::vector<CResult>& results,
+                                     const std::vector<CResourceIdleTime>& resource_idle_times)
+{
+	for (const CResult& result : results)
+	{
+		stream << "Cores: " << result.numCores
+			<< ", makespan: " << result.makespan.count() << "ns"
+			<< ", speedup: " << result.speedup
+			<< ", utilization: " << result.utilization << "\n";
+	}
+	for (const CResourceIdleTime& idleTime : resource_idle_times)
+	{
+		if (idleTime.idleTime == TCost::zero())
+			continue;
+		stream << "Idle time caused by " << idleTime.className << "::" << idleTime.memberName
+			<< ": " << idleTime.idleTime.count() << "ns\n";
+	}
+}
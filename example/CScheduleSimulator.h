@@ -0,0 +1,76 @@
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "Task.hpp"
+
+/**
+ * \brief Offline replay of the batch scheduler on virtual cores, for capacity planning.
+ *        Only the filtered resources and the costs of the tasks are used, the task bodies never run,
+ *        so the results are deterministic.
+ *        The execution graph is built like the scheduler does and ready tasks are started
+ *        with its policies: higher lanes first, then critical path first.
+ *        Fusion is not replayed, since the simulation has no per-task overhead.
+ *        Tasks without a declared or measured cost count as zero.
+ */
+class CScheduleSimulator
+{
+public:
+	using TCost = ITask::TCost;
+
+	static constexpr size_t MAX_CORES = 64;
+
+	struct CResult
+	{
+		size_t numCores;
+		TCost makespan;
+		// sum of all task costs, the makespan on one core
+		TCost totalWork;
+		// costs along the longest path of the graph, no number of cores is faster
+		TCost criticalPath;
+		// busy time of all cores relative to numCores * makespan
+		double utilization;
+		// totalWork relative to the makespan
+		double speedup;
+	};
+
+	struct CResourceIdleTime
+	{
+		size_t resourceHashCode;
+		std::string_view className;
+		std::string_view memberName;
+		// idle core time that disappears, if the resource no longer orders any tasks (e.g. after splitting it)
+		TCost idleTime;
+	};
+
+	CScheduleSimulator() = default;
+	~CScheduleSimulator() = default;
+
+	/**
+	 * \brief Simulates the batch in the order it would be passed to the scheduler.
+	 * \param task_list The task batch
+	 * \param num_cores Number of virtual cores, at least one
+	 */
+	static CResult Simulate(const std::vector<std::shared_ptr<ITask>>& task_list, size_t num_cores);
+
+	/**
+	 * \brief Simulates the batch on 1 to max_cores cores.
+	 * \return One result per core count, starting with one core
+	 */
+	static std::vector<CResult> SimulateSpeedup(const std::vector<std::shared_ptr<ITask>>& task_list,
+	                                            size_t max_cores = MAX_CORES);
+
+	/**
+	 * \brief Computes the idle time caused by every resource of the batch,
+	 *        by simulating the batch once more without the edges of that resource.
+	 * \return Resources sorted by idle time, the largest first
+	 */
+	static std::vector<CResourceIdleTime> ComputeResourceIdleTimes(
+		const std::vector<std::shared_ptr<ITask>>& task_list, size_t num_cores);
+
+	static void PrintReport(std::ostream& stream, const std::vector<CResult>& results,
+	                        const std::vector<CResourceIdleTime>& resource_idle_times);
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <array>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include <MetaSchedule.hpp>
+
+#include "Task.hpp"
+
+/**
+ * \brief Executes a fixed set of tasks with an execution graph computed at compile time.
+ *        No graph is built at runtime, only the execution loop remains.
+ * \tparam Tasks List of CTask types, in the order they would be pushed into the task queue
+ */
+template <typename... Tasks>
+class CStaticTaskScheduler
+{
+public:
+	using TSchedule = Meta::CStaticSchedule<Tasks...>;
+
+	CStaticTaskScheduler() = default;
+	~CStaticTaskScheduler() = default;
+
+	static void ExecuteTasks(const std::shared_ptr<Tasks>&... tasks);
+};
+
+template <typename... Tasks>
+void CStaticTaskScheduler<Tasks...>::ExecuteTasks(const std::shared_ptr<Tasks>&... tasks)
+{
+	constexpr size_t numTasks = TSchedule::NUM_TASKS;
+	const std::array<const ITask*, numTasks> taskList{tasks.get()...};
+	std::array<std::shared_future<void>, numTasks> executedTasks;
+
+	// the order is topological, so all parents are started before their children
+	for (const size_t taskVertex : TSchedule::ORDER)
+	{
+		std::vector<std::shared_future<void>> parentTasks;
+		parentTasks.reserve(TSchedule::IN_DEGREES[taskVertex]);
+		for (size_t parent = 0; parent < numTasks; ++parent)
+			if (TSchedule::EDGES[parent][taskVertex])
+				parentTasks.push_back(executedTasks[parent]);
+
+		executedTasks[taskVertex] = std::async(
+			std::launch::async,
+			[pTask = taskList[taskVertex], parentTasks = std::move(parentTasks)]()
+			{
+				// wait for all parent tasks
+				for (auto&& parentTask : parentTasks)
+					parentTask.wait();
+
+				pTask->DoTask();
+			}
+		).share();
+	}
+
+	for (auto&& executedTask : executedTasks)
+		executedTask.wait();
+}
@@ -0,0 +1,292 @@
+#include "CStreamingTaskScheduler.h"
+
+#include <algorithm>
+
+CStreamingTaskScheduler::CStreamingTaskScheduler(const size_t num_workers, const size_t num_reserved_workers,
+                                                 const CCpuTopology* topology)
+	: pOwnedWorkerPool(std::make_unique<CWorkerPool>(num_workers, num_reserved_workers, topology)),
+	  executor(*pOwnedWorkerPool)
+{
+}
+
+CStreamingTaskScheduler::CStreamingTaskScheduler(ITaskExecutor& executor)
+	: executor(executor)
+{
+}
+
+CStreamingTaskScheduler::~CStreamingTaskScheduler()
+{
+	WaitIdle();
+}
+
+void CStreamingTaskScheduler::Submit(std::shared_ptr<ITask> task)
+{
+	std::unique_lock lock(mutex);
+	std::shared_ptr<CTaskNode> pReadyNode = AddNode(std::move(task), NO_FRAME);
+	lock.unlock();
+
+	if (pReadyNode)
+		Dispatch(std::move(pReadyNode));
+}
+
+CStreamingTaskScheduler::TFrameId CStreamingTaskScheduler::SubmitFrame(std::queue<std::shared_ptr<ITask>> task_queue)
+{
+	std::vector<std::shared_ptr<CTaskNode>> readyNodes;
+
+	std::unique_lock lock(mutex);
+	// bound the number of frames in flight
+	frameCondition.wait(lock, [this] { return unfinishedFrameTasks.size() < maxFramesInFlight; });
+	const TFrameId frameId = nextFrameId++;
+	if (!task_queue.empty())
+		unfinishedFrameTasks[frameId] = task_queue.size();
+
+	while (!task_queue.empty())
+	{
+		if (auto pReadyNode = AddNode(std::move(task_queue.front()), frameId))
+			readyNodes.push_back(std::move(pReadyNode));
+		task_queue.pop();
+	}
+	lock.unlock();
+
+	for (auto&& pReadyNode : readyNodes)
+		Dispatch(std::move(pReadyNode));
+	return frameId;
+}
+
+void CStreamingTaskScheduler::WaitFrame(const TFrameId frame_id)
+{
+	std::unique_lock lock(mutex);
+	frameCondition.wait(lock, [&] { return !unfinishedFrameTasks.contains(frame_id); });
+}
+
+void CStreamingTaskScheduler::WaitIdle()
+{
+	// a blocked worker might be the one needed to finish the tasks
+	if (executor.IsWorkerThread())
+	{
+		HelpUntilIdle();
+		return;
+	}
+
+	std::unique_lock lock(mutex);
+	idleCondition.wait(lock, [this] { return numUnfinishedTasks == 0; });
+}
+
+void CStreamingTaskScheduler::HelpUntilIdle()
+{
+	executor.HelpUntil([this]
+	{
+		std::scoped_lock lock(mutex);
+		return numUnfinishedTasks == 0;
+	});
+}
+
+void CStreamingTaskScheduler::SetMaxFramesInFlight(const size_t max_frames_in_flight)
+{
+	{
+		std::scoped_lock lock(mutex);
+		maxFramesInFlight = std::max<size_t>(max_frames_in_flight, 1);
+	}
+	frameCondition.notify_all();
+}
+
+std::shared_ptr<CStreamingTaskScheduler::CTaskNode> CStreamingTaskScheduler::AddNode(
+	std::shared_ptr<ITask> task, const TFrameId frame_id)
+{
+	auto pNode = std::make_shared<CTaskNode>();
+	pNode->pTask = std::move(task);
+	pNode->frameId = frame_id;
+	++numUnfinishedTasks;
+
+	std::vector<CTaskNode*> parents;
+	for (const Meta::CResourceAccessInfo& resource : pNode->pTask->GetResourceAccessInfos())
+	{
+		if (resource.objectLevel)
+			AccessObject(resource, pNode, parents);
+		else
+			AccessMember(resource, pNode, parents);
+	}
+
+	if (pNode->numPendingParents > 0)
+		return nullptr;
+	return pNode;
+}
+
+void CStreamingTaskScheduler::AccessResource(CResourceState& state, const Meta::EResourceAccessMode access_mode,
+                                             const std::shared_ptr<CTaskNode>& p_node,
+                                             std::vector<CTaskNode*>& parents)
+{
+	// forget readers which are done already
+	std::erase_if(state.activeReaders, [](const std::shared_ptr<CTaskNode>& p_reader)
+	{
+		return p_reader->finished;
+	});
+
+	if (access_mode == Meta::EResourceAccessMode::WRITE)
+	{
+		// a writer waits for the previous writer and all readers since then
+		AttachToParent(state.pLastWriter, p_node, parents);
+		for (auto&& pReader : state.activeReaders)
+			AttachToParent(pReader, p_node, parents);
+		state.pLastWriter = p_node;
+		state.activeReaders.clear();
+	}
+	else
+	{
+		// a reader only waits for the previous writer
+		AttachToParent(state.pLastWriter, p_node, parents);
+		state.activeReaders.push_back(p_node);
+	}
+}
+
+void CStreamingTaskScheduler::AccessMember(const Meta::CResourceAccessInfo& resource,
+                                           const std::shared_ptr<CTaskNode>& p_node, std::vector<CTaskNode*>& parents)
+{
+	CResourceState& state = resourceStates[resource.hashCode];
+	state.classHashCode = resource.classHashCode;
+	AccessResource(state, resource.accessMode, p_node, parents);
+
+	// most classes are never accessed as a whole object
+	if (!objectClasses.MayContain(resource.classHashCode))
+		return;
+	const auto objectState = resourceStates.find(resource.objectHashCode);
+	if (objectState == resourceStates.end())
+		return;
+
+	// the member access counts as a read of the whole object for other member accesses,
+	// but a write of the whole object has to wait for it
+	CResourceState& object = objectState->second;
+	auto isFinished = [](const std::shared_ptr<CTaskNode>& p_other) { return p_other->finished; };
+	AttachToParent(object.pLastWriter, p_node, parents);
+	if (resource.accessMode == Meta::EResourceAccessMode::WRITE)
+	{
+		std::erase_if(object.activeReaders, isFinished);
+		for (auto&& pReader : object.activeReaders)
+			AttachToParent(pReader, p_node, parents);
+		std::erase_if(object.memberWriters, isFinished);
+		object.memberWriters.push_back(p_node);
+	}
+	else
+	{
+		std::erase_if(object.memberReaders, isFinished);
+		object.memberReaders.push_back(p_node);
+	}
+}
+
+void CStreamingTaskScheduler::AccessObject(const Meta::CResourceAccessInfo& resource,
+                                           const std::shared_ptr<CTaskNode>& p_node, std::vector<CTaskNode*>& parents)
+{
+	const bool firstAccess = !resourceStates.contains(resource.hashCode);
+	CResourceState& object = resourceStates[resource.hashCode];
+	object.classHashCode = resource.classHashCode;
+	if (firstAccess)
+	{
+		objectClasses.Add(resource.classHashCode);
+		// the member accesses submitted so far did not know about the object state yet
+		for (auto&& [hashCode, state] : resourceStates)
+		{
+			if (hashCode == resource.hashCode || state.classHashCode != resource.classHashCode)
+				continue;
+			if (state.pLastWriter)
+				object.memberWriters.push_back(state.pLastWriter);
+			object.memberReaders.insert(object.memberReaders.end(), state.activeReaders.begin(), state.activeReaders.end());
+		}
+	}
+
+	auto isFinished = [](const std::shared_ptr<CTaskNode>& p_member) { return p_member->finished; };
+	std::erase_if(object.memberWriters, isFinished);
+	std::erase_if(object.memberReaders, isFinished);
+
+	// conflicts with every member writer, a write also with every member reader
+	for (auto&& pWriter : object.memberWriters)
+		AttachToParent(pWriter, p_node, parents);
+	if (resource.accessMode == Meta::EResourceAccessMode::WRITE)
+	{
+		for (auto&& pReader : object.memberReaders)
+			AttachToParent(pReader, p_node, parents);
+		object.memberWriters.clear();
+		object.memberReaders.clear();
+	}
+	AccessResource(object, resource.accessMode, p_node, parents);
+}
+
+void CStreamingTaskScheduler::AttachToParent(const std::shared_ptr<CTaskNode>& p_parent,
+                                             const std::shared_ptr<CTaskNode>& p_child,
+                                             std::vector<CTaskNode*>& parents)
+{
+	if (!p_parent || p_parent == p_child || p_parent->finished)
+		return;
+	// the same parent may be found via multiple resources
+	if (std::ranges::find(parents, p_parent.get()) != parents.end())
+		return;
+	parents.push_back(p_parent.get());
+	p_parent->children.push_back(p_child);
+	++p_child->numPendingParents;
+}
+
+void CStreamingTaskScheduler::ForgetNode(const std::shared_ptr<CTaskNode>& p_node)
+{
+	auto isNode = [&p_node](const std::shared_ptr<CTaskNode>& p_other) { return p_other == p_node; };
+	auto forget = [&](CResourceState& state)
+	{
+		if (state.pLastWriter == p_node)
+			state.pLastWriter.reset();
+		std::erase_if(state.activeReaders, isNode);
+		std::erase_if(state.memberWriters, isNode);
+		std::erase_if(state.memberReaders, isNode);
+	};
+
+	for (const Meta::CResourceAccessInfo& resource : p_node->pTask->GetResourceAccessInfos())
+	{
+		if (const auto state = resourceStates.find(resource.hashCode); state != resourceStates.end())
+			forget(state->second);
+		// member accesses are also recorded in the state of the whole object
+		if (!resource.objectLevel && objectClasses.MayContain(resource.classHashCode))
+			if (const auto objectState = resourceStates.find(resource.objectHashCode); objectState != resourceStates.end())
+				forget(objectState->second);
+	}
+}
+
+void CStreamingTaskScheduler::Dispatch(std::shared_ptr<CTaskNode> p_node)
+{
+	const ETaskLane lane = p_node->pTask->GetLane();
+	const size_t nodeHint = p_node->pTask->GetNodeHint();
+	// the node keeps the task and so its resources alive until the job is done
+	const std::vector<Meta::CResourceAccessInfo>& resources = p_node->pTask->GetResourceAccessInfos();
+	// successive writers of a resource run on the same worker, if it is not busy for too long
+	executor.EnqueueWithAffinity([this, pNode = std::move(p_node)]()
+	{
+		// a suspended task releases the worker, its dependents wait until it completes
+		pNode->pTask->StartAsync([this, pNode] { OnTaskFinished(pNode); });
+	}, resources, lane, nodeHint);
+}
+
+void CStreamingTaskScheduler::OnTaskFinished(const std::shared_ptr<CTaskNode>& p_node)
+{
+	std::vector<std::shared_ptr<CTaskNode>> readyTasks;
+	{
+		std::scoped_lock lock(mutex);
+		p_node->finished = true;
+		for (auto&& pChild : p_node->children)
+			if (--pChild->numPendingParents == 0)
+				readyTasks.push_back(pChild);
+		p_node->children.clear();
+		ForgetNode(p_node);
+	}
+
+	for (auto&& pReadyTask : readyTasks)
+		Dispatch(pReadyTask);
+
+	std::scoped_lock lock(mutex);
+	// notify while holding the lock, the scheduler may be destroyed right after the wait returns
+	if (p_node->frameId != NO_FRAME && --unfinishedFrameTasks.at(p_node->frameId) == 0)
+	{
+		unfinishedFrameTasks.erase(p_node->frameId);
+		frameCondition.notify_all();
+	}
+	if (--numUnfinishedTasks == 0)
+	{
+		idleCondition.notify_all();
+		executor.NotifyHelpers();
+	}
+}
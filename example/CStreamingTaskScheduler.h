@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cassert>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "CWorkerPool.h"
+#include "Task.hpp"
+
+/**
+ * \brief Schedules tasks as they are submitted, without waiting for a whole batch.
+ *        The state of every resource (last writer, active readers) is tracked online,
+ *        so a new task only waits for the conflicting tasks submitted before it
+ *        and starts right away if there are none.
+ *        An access to a whole object waits for the accesses to its members and the other way around,
+ *        accesses to different members of an object stay independent.
+ *        Whole batches can be submitted as frames, which are pipelined:
+ *        a frame may start while the previous frames are still running.
+ */
+class CStreamingTaskScheduler
+{
+public:
+	using TFrameId = size_t;
+
+	/**
+	 * \param num_workers Number of worker threads executing the tasks
+	 * \param num_reserved_workers Number of workers only executing tasks of the high lane
+	 * \param topology Pins the workers to the CPUs of the topology, see CWorkerPool
+	 */
+	explicit CStreamingTaskScheduler(size_t num_workers = std::thread::hardware_concurrency(),
+	                                 size_t num_reserved_workers = 0, const CCpuTopology* topology = nullptr);
+	/**
+	 * \param executor Existing pool or other executor executing the tasks, has to outlive the scheduler
+	 */
+	explicit CStreamingTaskScheduler(ITaskExecutor& executor);
+	// waits for all submitted tasks
+	~CStreamingTaskScheduler();
+
+	/**
+	 * \brief Attaches the task to its predecessors or starts it immediately.
+	 *        Tasks conflicting on a resource are executed in submission order.
+	 */
+	void Submit(std::shared_ptr<ITask> task);
+
+	/**
+	 * \brief Submits a batch of tasks as one frame.
+	 *        The tasks are connected to the still running tasks of the previous frames by their resources,
+	 *        so only conflicting tasks wait and there is no barrier between frames.
+	 *        Blocks while the maximum number of frames is in flight.
+	 * \param task_queue The tasks of this frame, conflicting tasks are executed in queue order
+	 * \return Id of the frame
+	 */
+	TFrameId SubmitFrame(std::queue<std::shared_ptr<ITask>> task_queue);
+
+	// blocks until all tasks of the given frame have finished
+	void WaitFrame(TFrameId frame_id);
+
+	/**
+	 * \brief Blocks until all submitted tasks have finished.
+	 *        Called from a worker of the executor, it helps executing jobs instead of blocking the worker.
+	 */
+	void WaitIdle();
+
+	// executes jobs of the executor on the calling thread until all submitted tasks have finished
+	void HelpUntilIdle();
+
+	/**
+	 * \brief Sets the number of frames that may run at the same time.
+	 *        1 turns the pipelining off, every frame waits for the previous one.
+	 */
+	void SetMaxFramesInFlight(size_t max_frames_in_flight);
+
+	// executor of the tasks, also used for splitting up work inside of tasks, e.g. for CParallelTask
+	ITaskExecutor& GetExecutor() { return executor; }
+
+	// the pool created by the scheduler, only if it was not given an executor
+	CWorkerPool& GetWorkerPool()
+	{
+		assert(pOwnedWorkerPool && "The scheduler was given an executor.");
+		return *pOwnedWorkerPool;
+	}
+
+private:
+	static constexpr TFrameId NO_FRAME = static_cast<TFrameId>(-1);
+
+	struct CTaskNode
+	{
+		std::shared_ptr<ITask> pTask;
+		TFrameId frameId = NO_FRAME;
+		size_t numPendingParents = 0;
+		bool finished = false;
+		std::vector<std::shared_ptr<CTaskNode>> children;
+	};
+
+	struct CResourceState
+	{
+		std::shared_ptr<CTaskNode> pLastWriter;
+		// readers since the last writer
+		std::vector<std::shared_ptr<CTaskNode>> activeReaders;
+		size_t classHashCode = 0;
+		// only for accesses to whole objects: member writers and readers since the last write to the whole object
+		std::vector<std::shared_ptr<CTaskNode>> memberWriters;
+		std::vector<std::shared_ptr<CTaskNode>> memberReaders;
+	};
+
+	std::mutex mutex;
+	std::condition_variable idleCondition;
+	std::condition_variable frameCondition;
+	size_t numUnfinishedTasks = 0;
+	size_t maxFramesInFlight = 2;
+	TFrameId nextFrameId = 0;
+	// unfinished tasks per frame, finished frames are removed
+	std::unordered_map<TFrameId, size_t> unfinishedFrameTasks;
+	// state per resource hash code
+	std::unordered_map<size_t, CResourceState> resourceStates;
+	// classes accessed as a whole object, member accesses of other classes skip the lookup of the object state
+	Meta::CClassSummary objectClasses;
+	// declared last, so the own workers are joined before anything else is destroyed
+	std::unique_ptr<CWorkerPool> pOwnedWorkerPool;
+	ITaskExecutor& executor;
+
+	// creates the node and attaches it to its predecessors, returns the node if it is ready to run
+	std::shared_ptr<CTaskNode> AddNode(std::shared_ptr<ITask> task, TFrameId frame_id);
+	// attaches the node to the predecessors accessing the resource and records the access
+	static void AccessResource(CResourceState& state, Meta::EResourceAccessMode access_mode,
+	                           const std::shared_ptr<CTaskNode>& p_node, std::vector<CTaskNode*>& parents);
+	// access to a single member, also waits for the accesses to the whole object
+	void AccessMember(const Meta::CResourceAccessInfo& resource, const std::shared_ptr<CTaskNode>& p_node,
+	                  std::vector<CTaskNode*>& parents);
+	// access to the whole object, also waits for the accesses to its members
+	void AccessObject(const Meta::CResourceAccessInfo& resource, const std::shared_ptr<CTaskNode>& p_node,
+	                  std::vector<CTaskNode*>& parents);
+	// adds an edge from parent to child, if the parent is still running and not yet a parent of child
+	static void AttachToParent(const std::shared_ptr<CTaskNode>& p_parent, const std::shared_ptr<CTaskNode>& p_child,
+	                           std::vector<CTaskNode*>& parents);
+	// drops the references of the resource states to the finished node, so its task and captures are released
+	void ForgetNode(const std::shared_ptr<CTaskNode>& p_node);
+	void Dispatch(std::shared_ptr<CTaskNode> p_node);
+	void OnTaskFinished(const std::shared_ptr<CTaskNode>& p_node);
+};
@@ -0,0 +1,76 @@
+#include "CTaskCoroutine.h"
+
+#include <cassert>
+#include <utility>
+
+void CTaskCoroutine::CPromise::ResumeOnExecutor()
+{
+	assert(pExecutor && "The coroutine was not started by its task.");
+	const THandle handle = THandle::from_promise(*this);
+	pExecutor->Enqueue([handle] { handle.resume(); }, lane);
+}
+
+CTaskCoroutine::CTaskCoroutine(const THandle handle)
+	: handle(handle)
+{
+}
+
+CTaskCoroutine::~CTaskCoroutine()
+{
+	if (handle)
+		handle.destroy();
+}
+
+CTaskCoroutine::CTaskCoroutine(CTaskCoroutine&& other) noexcept
+	: handle(std::exchange(other.handle, nullptr))
+{
+}
+
+CTaskCoroutine& CTaskCoroutine::operator=(CTaskCoroutine&& other) noexcept
+{
+	if (this != &other)
+	{
+		if (handle)
+			handle.destroy();
+		handle = std::exchange(other.handle, nullptr);
+	}
+	return *this;
+}
+
+void CTaskCoroutine::Start(ITaskExecutor& executor, const ETaskLane lane, ITask::TCompletion&& on_finished)
+{
+	assert(handle && !handle.done() && "The coroutine can only be started once.");
+	CPromise& promise = handle.promise();
+	promise.pExecutor = &executor;
+	promise.lane = lane;
+	promise.onFinished = std::move(on_finished);
+	handle.resume();
+}
+
+void CTaskEvent::Signal()
+{
+	CTaskCoroutine::THandle waitingTask;
+	{
+		std::scoped_lock lock(mutex);
+		signaled = true;
+		waitingTask = std::exchange(waiter, nullptr);
+	}
+	if (waitingTask)
+		waitingTask.promise().ResumeOnExecutor();
+}
+
+bool CTaskEvent::IsSignaled() const
+{
+	std::scoped_lock lock(mutex);
+	return signaled;
+}
+
+bool CTaskEvent::SetWaiter(const CTaskCoroutine::THandle handle)
+{
+	std::scoped_lock lock(mutex);
+	assert(!waiter && "Only one task can wait for an event.");
+	if (signaled)
+		return false;
+	waiter = handle;
+	return true;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <coroutine>
+#include <mutex>
+
+#include "ITaskExecutor.h"
+#include "Task.hpp"
+
+/**
+ * \brief Return type of the bodies of coroutine tasks (see CCoroutineTask).
+ *        The coroutine starts suspended and is started on a worker by the task.
+ *        Every time it is resumed after a suspension it continues on a worker of the pool, not on the thread resuming it.
+ *        When it returns, the completion of the task is called.
+ */
+class CTaskCoroutine
+{
+public:
+	class CPromise
+	{
+	public:
+		CTaskCoroutine get_return_object() { return CTaskCoroutine(THandle::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+
+		auto final_suspend() noexcept
+		{
+			struct CFinalAwaiter
+			{
+				bool await_ready() noexcept { return false; }
+
+				void await_suspend(const THandle handle) noexcept
+				{
+					// the completion may destroy the task and so the coroutine, nothing of it is touched after the call
+					const ITask::TCompletion onFinished = std::move(handle.promise().onFinished);
+					onFinished();
+				}
+
+				void await_resume() noexcept {}
+			};
+			return CFinalAwaiter{};
+		}
+
+		void return_void() {}
+		// tasks don't throw
+		void unhandled_exception() { std::terminate(); }
+
+		// continues the suspended coroutine on a worker, safe to call from any thread
+		void ResumeOnExecutor();
+
+	private:
+		friend class CTaskCoroutine;
+
+		ITaskExecutor* pExecutor = nullptr;
+		ETaskLane lane = ETaskLane::NORMAL;
+		ITask::TCompletion onFinished;
+	};
+
+	using promise_type = CPromise;
+	using THandle = std::coroutine_handle<CPromise>;
+
+	CTaskCoroutine() = default;
+	~CTaskCoroutine();
+
+	CTaskCoroutine(CTaskCoroutine&& other) noexcept;
+	CTaskCoroutine& operator=(CTaskCoroutine&& other) noexcept;
+
+	/**
+	 * \brief Runs the coroutine on the calling thread until it suspends for the first time or returns.
+	 * \param executor Executor the coroutine continues on after a suspension
+	 * \param lane Lane of the jobs continuing the coroutine
+	 * \param on_finished Called once the coroutine returned
+	 */
+	void Start(ITaskExecutor& executor, ETaskLane lane, ITask::TCompletion&& on_finished);
+
+private:
+	THandle handle;
+
+	explicit CTaskCoroutine(THandle handle);
+};
+
+/**
+ * \brief One-shot event a coroutine task can wait for, e.g. the completion of a read.
+ *        Signal it from the thread noticing the completion, like an epoll or io_uring loop,
+ *        the waiting task continues on its pool.
+ */
+class CTaskEvent
+{
+public:
+	CTaskEvent() = default;
+	~CTaskEvent() = default;
+
+	CTaskEvent(const CTaskEvent&) = delete;
+	CTaskEvent& operator=(const CTaskEvent&) = delete;
+
+	// resumes the waiting task, safe to call from any thread
+	void Signal();
+	bool IsSignaled() const;
+
+	/**
+	 * \brief Suspends the calling coroutine task until the event is signaled, does not suspend if it already is.
+	 *        At most one task may wait for the event.
+	 */
+	auto operator co_await()
+	{
+		struct CAwaiter
+		{
+			CTaskEvent& event;
+
+			bool await_ready() const { return event.IsSignaled(); }
+			bool await_suspend(const CTaskCoroutine::THandle handle) { return event.SetWaiter(handle); }
+			void await_resume() const {}
+		};
+		return CAwaiter{*this};
+	}
+
+private:
+	mutable std::mutex mutex;
+	bool signaled = false;
+	CTaskCoroutine::THandle waiter;
+
+	// false if the event was signaled in the meantime, then the coroutine continues right away
+	bool SetWaiter(CTaskCoroutine::THandle handle);
+};
@@ -0,0 +1,185 @@
+#include "CTaskCostDatabase.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <limits>
+#include <typeinfo>
+#include <vector>
+
+namespace
+{
+	// file layout: header, followed by numEntries records, all values little endian
+	constexpr std::array<char, 4> FILE_MAGIC{'T', 'C', 'D', 'B'};
+
+	struct CFileHeader
+	{
+		std::array<char, 4> magic;
+		std::uint32_t version;
+		std::uint64_t numEntries;
+	};
+
+	struct CFileRecord
+	{
+		std::uint64_t taskKey;
+		std::uint64_t averageNanoseconds;
+		std::uint32_t numSamples;
+	};
+
+	template <typename T>
+	void WriteValue(std::ostream& stream, T value)
+	{
+		for (size_t idx = 0; idx < sizeof(T); ++idx)
+			stream.put(static_cast<char>(static_cast<std::uint64_t>(value) >> (idx * 8) & 0xff));
+	}
+
+	template <typename T>
+	bool ReadValue(std::istream& stream, T& value)
+	{
+		std::uint64_t result = 0;
+		for (size_t idx = 0; idx < sizeof(T); ++idx)
+		{
+			const int byte = stream.get();
+			if (byte == std::char_traits<char>::eof())
+				return false;
+			result |= static_cast<std::uint64_t>(byte) << (idx * 8);
+		}
+		value = static_cast<T>(result);
+		return true;
+	}
+}
+
+CTaskCostDatabase::CTaskCostDatabase(const double smoothing)
+	: smoothing(std::clamp(smoothing, 0.0, 1.0))
+{
+}
+
+CTaskCostDatabase::TTaskKey CTaskCostDatabase::GetTaskKey(const ITask& task)
+{
+	// the type name is specific to the compiler and its ABI, e.g. mangled by GCC and Clang but not by MSVC,
+	// so a file written by a build of one compiler has no matching keys for a build of another
+
+	return GetTaskKey(typeid(task).name());
+}
+
+CTaskCostDatabase::TTaskKey CTaskCostDatabase::GetTaskKey(const std::string_view type_name)
+{
+	// FNV-1a
+	constexpr std::uint64_t offsetBasis = 0xcbf29ce484222325;
+	constexpr std::uint64_t prime = 0x100000001b3;
+	std::uint64_t hash = offsetBasis;
+	for (const char character : type_name)
+	{
+		hash ^= static_cast<std::uint64_t>(static_cast<unsigned char>(character));
+		hash *= prime;
+	}
+	return hash;
+}
+
+void CTaskCostDatabase::Record(const ITask& task, const TCost measured_cost)
+{
+	Record(GetTaskKey(task), measured_cost);
+}
+
+void CTaskCostDatabase::Record(const TTaskKey task_key, const TCost measured_cost)
+{
+	const auto measured = static_cast<double>(measured_cost.count());
+	std::scoped_lock lock(mutex);
+	CEntry& entry = entries[task_key];
+	// the first measurement starts the average
+	entry.averageNanoseconds = entry.numSamples == 0
+		                           ? measured
+		                           : entry.averageNanoseconds + smoothing * (measured - entry.averageNanoseconds);
+	if (entry.numSamples < std::numeric_limits<std::uint32_t>::max())
+		++entry.numSamples;
+}
+
+std::optional<CTaskCostDatabase::TCost> CTaskCostDatabase::GetCost(const ITask& task) const
+{
+	return GetCost(GetTaskKey(task));
+}
+
+std::optional<CTaskCostDatabase::TCost> CTaskCostDatabase::GetCost(const TTaskKey task_key) const
+{
+	std::scoped_lock lock(mutex);
+	const auto entry = entries.find(task_key);
+	if (entry == entries.end() || entry->second.numSamples == 0)
+		return std::nullopt;
+	return TCost(static_cast<TCost::rep>(entry->second.averageNanoseconds));
+}
+
+size_t CTaskCostDatabase::GetNumEntries() const
+{
+	std::scoped_lock lock(mutex);
+	return entries.size();
+}
+
+bool CTaskCostDatabase::Load(const std::filesystem::path& file_path)
+{
+	std::ifstream file(file_path, std::ios::binary);
+	if (!file)
+		return false;
+
+	CFileHeader header{};
+	for (char& character : header.magic)
+		character = static_cast<char>(file.get());
+	if (!file || header.magic != FILE_MAGIC
+		|| !ReadValue(file, header.version) || header.version != FILE_VERSION
+		|| !ReadValue(file, header.numEntries))
+		return false;
+
+	// read everything first, so a truncated file does not leave a partly loaded database
+	std::vector<CFileRecord> records;
+	for (std::uint64_t idx = 0; idx < header.numEntries; ++idx)
+	{
+		CFileRecord record{};
+		if (!ReadValue(file, record.taskKey) || !ReadValue(file, record.averageNanoseconds)
+			|| !ReadValue(file, record.numSamples))
+			return false;
+		records.push_back(record);
+	}
+
+	std::scoped_lock lock(mutex);
+	for (const CFileRecord& record : records)
+		entries[record.taskKey] = CEntry{static_cast<double>(record.averageNanoseconds), record.numSamples};
+	return true;
+}
+
+bool CTaskCostDatabase::Save(const std::filesystem::path& file_path) const
+{
+	// written next to the file and renamed over it, so a failed write never destroys the saved costs
+	std::filesystem::path tempPath = file_path;
+	tempPath += ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+
+		std::scoped_lock lock(mutex);
+		file.write(FILE_MAGIC.data(), FILE_MAGIC.size());
+		WriteValue(file, FILE_VERSION);
+		WriteValue(file, static_cast<std::uint64_t>(entries.size()));
+		for (auto&& [taskKey, entry] : entries)
+		{
+			WriteValue(file, taskKey);
+			WriteValue(file, static_cast<std::uint64_t>(entry.averageNanoseconds));
+			WriteValue(file, entry.numSamples);
+		}
+		file.close();
+		if (!file)
+		{
+			std::error_code error;
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, file_path, error);
+	if (error)
+	{
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
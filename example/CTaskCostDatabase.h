@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+#include "Task.hpp"
+
+/**
+ * \brief Profile-guided task costs: the measured execution times per task type as exponential moving average.
+ *        The averages are persisted in a small binary file, so the scheduler starts with tuned costs after a restart.
+ *        Task types are identified by a hash of their type name, which stays the same across runs
+ *        (unlike std::type_info::hash_code), as long as the binary is built by the same compiler.
+ *        Entries of task types that no longer exist are kept, new task types are simply added.
+ */
+class CTaskCostDatabase
+{
+public:
+	using TCost = ITask::TCost;
+	using TTaskKey = std::uint64_t;
+
+	// increased on every change of the file layout, files of other versions are ignored
+	static constexpr std::uint32_t FILE_VERSION = 1;
+
+	/**
+	 * \param smoothing Weight of a new measurement in the moving average, between 0 (never changes) and 1 (last value)
+	 */
+	explicit CTaskCostDatabase(double smoothing = 0.2);
+	~CTaskCostDatabase() = default;
+
+	// stable identity of the dynamic type of the task, hashed from typeid(task).name(), which depends on the compiler
+	static TTaskKey GetTaskKey(const ITask& task);
+	static TTaskKey GetTaskKey(std::string_view type_name);
+
+	/**
+	 * \brief Adds a measured execution time to the moving average of the task type.
+	 *        Safe to call from multiple threads.
+	 */
+	void Record(const ITask& task, TCost measured_cost);
+	void Record(TTaskKey task_key, TCost measured_cost);
+
+	// moving average of the task type, empty if it was never measured
+	std::optional<TCost> GetCost(const ITask& task) const;
+	std::optional<TCost> GetCost(TTaskKey task_key) const;
+
+	size_t GetNumEntries() const;
+
+	/**
+	 * \brief Merges the entries of the file into the database, loaded entries replace existing ones.
+	 * \return false if the file does not exist, has another version or is damaged, nothing is loaded then
+	 */
+	bool Load(const std::filesystem::path& file_path);
+
+	/**
+	 * \brief Writes all entries to the file, replacing it.
+	 *        The entries are written to a temporary file first, which replaces the file once it is complete,
+	 *        so the previous file stays intact if writing fails.
+	 * \return false if the file could not be written
+	 */
+	bool Save(const std::filesystem::path& file_path) const;
+
+private:
+	struct CEntry
+	{
+		double averageNanoseconds = 0.0;
+		std::uint32_t numSamples = 0;
+	};
+
+	const double smoothing;
+	mutable std::mutex mutex;
+	std::unordered_map<TTaskKey, CEntry> entries;
+};
@@ -0,0 +1,48 @@
+#include "CTaskResultArena.h"
+
+CTaskResultArena::CTaskResultArena(const size_t initial_block_size)
+	: memory(initial_block_size)
+{
+}
+
+CTaskResultArena::~CTaskResultArena()
+{
+	Reset();
+}
+
+void CTaskResultArena::Reset()
+{
+	std::scoped_lock lock(mutex);
+	// in reverse order of construction, like the members of a class
+	for (auto it = destructors.rbegin(); it != destructors.rend(); ++it)
+		it->second(it->first);
+	destructors.clear();
+	memory.release();
+	numResults = 0;
+	++generation;
+}
+
+size_t CTaskResultArena::GetGeneration() const
+{
+	std::scoped_lock lock(mutex);
+	return generation;
+}
+
+size_t CTaskResultArena::GetNumResults() const
+{
+	std::scoped_lock lock(mutex);
+	return numResults;
+}
+
+void* CTaskResultArena::Allocate(const size_t size, const size_t alignment)
+{
+	std::scoped_lock lock(mutex);
+	++numResults;
+	return memory.allocate(size, alignment);
+}
+
+void CTaskResultArena::AddDestructor(void* p_value, const TDestructor destructor)
+{
+	std::scoped_lock lock(mutex);
+	destructors.emplace_back(p_value, destructor);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * \brief Storage for the intermediate results passed between tasks (see CDataflowTask).
+ *        Results are placed one after another in large blocks and released all at once,
+ *        so producing a result costs no heap allocation of its own.
+ */
+class CTaskResultArena
+{
+public:
+	static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+	explicit CTaskResultArena(size_t initial_block_size = DEFAULT_BLOCK_SIZE);
+	// destroys the remaining results
+	~CTaskResultArena();
+
+	CTaskResultArena(const CTaskResultArena&) = delete;
+	CTaskResultArena& operator=(const CTaskResultArena&) = delete;
+
+	/**
+	 * \brief Moves the value into the arena. Safe to call from multiple threads.
+	 * \return The stored value, valid until the next Reset
+	 */
+	template <typename T>
+	std::remove_cvref_t<T>* Store(T&& value);
+
+	/**
+	 * \brief Destroys all results and releases the memory for reuse.
+	 *        No task may access a result while this is called.
+	 */
+	void Reset();
+
+	// increased by every Reset, so outputs can tell if their value is still alive
+	size_t GetGeneration() const;
+	// number of stored results since the last Reset
+	size_t GetNumResults() const;
+
+private:
+	using TDestructor = void (*)(void*);
+
+	mutable std::mutex mutex;
+	std::pmr::monotonic_buffer_resource memory;
+	// results which are not trivially destructible
+	std::vector<std::pair<void*, TDestructor>> destructors;
+	size_t numResults = 0;
+	size_t generation = 0;
+
+	void* Allocate(size_t size, size_t alignment);
+	void AddDestructor(void* p_value, TDestructor destructor);
+};
+
+template <typename T>
+std::remove_cvref_t<T>* CTaskResultArena::Store(T&& value)
+{
+	using TValue = std::remove_cvref_t<T>;
+	// only the allocation is locked, the value is moved in by the calling thread
+	auto* pValue = new(Allocate(sizeof(TValue), alignof(TValue))) TValue(std::forward<T>(value));
+	if constexpr (!std::is_trivially_destructible_v<TValue>)
+		AddDestructor(pValue, [](void* p_value) { static_cast<TValue*>(p_value)->~TValue(); });
+	return pValue;
+}
@@ -1,5 +1,13 @@
 #include "CTaskScheduler.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <tuple>
 #include <vector>
 
 // take uint64_t, so we can use 64-bit pointers as unique id in the graph builder
@@ -11,10 +19,118 @@
 
 #include <include/entt/src/entt/graph/flow.hpp>
 
+#include "CResourceHierarchy.h"
 #include "MetaResourceVisitor.hpp"
 
+namespace
+{
+	constexpr size_t NUM_LANES = static_cast<size_t>(ETaskLane::BACKGROUND) + 1;
+
+	/**
+	 * \brief Computes the bottom level of every unit: its cost plus the most expensive path to a unit without children.
+	 *        Tasks without a known cost count as the smallest cost,
+	 *        so without any costs the priority is the number of units on the longest path.
+	 */
+	std::vector<CTaskScheduler::TCost> ComputeBottomLevels(const std::vector<CTaskScheduler::TExecutionUnit>& units,
+	                                                       const std::vector<std::vector<size_t>>& child_units,
+	                                                       const std::vector<std::shared_ptr<ITask>>& task_list)
+	{
+		using TCost = CTaskScheduler::TCost;
+		std::vector<TCost> bottomLevels(units.size(), TCost::zero());
+		// the units are in topological order, so all children are computed before their parents
+		for (size_t unit = units.size(); unit-- > 0;)
+		{
+			TCost longestChildPath = TCost::zero();
+			for (const size_t childUnit : child_units.at(unit))
+				longestChildPath = std::max(longestChildPath, bottomLevels.at(childUnit));
+
+			TCost unitCost = TCost::zero();
+			for (const size_t taskVertex : units.at(unit))
+				unitCost += std::max(task_list.at(taskVertex)->GetCost().value_or(TCost::zero()), TCost(1));
+			bottomLevels.at(unit) = unitCost + longestChildPath;
+		}
+		return bottomLevels;
+	}
+
+	/**
+	 * \brief Computes the lane of every unit: the most urgent lane of its tasks and of all its descendants,
+	 *        so a latency-critical task never waits for a predecessor queued behind background work.
+	 */
+	std::vector<ETaskLane> ComputeUnitLanes(const std::vector<CTaskScheduler::TExecutionUnit>& units,
+	                                        const std::vector<std::vector<size_t>>& child_units,
+	                                        const std::vector<std::shared_ptr<ITask>>& task_list)
+	{
+		std::vector<ETaskLane> lanes(units.size(), ETaskLane::BACKGROUND);
+		// the units are in topological order, so all children are computed before their parents
+		for (size_t unit = units.size(); unit-- > 0;)
+		{
+			for (const size_t taskVertex : units.at(unit))
+				lanes.at(unit) = std::min(lanes.at(unit), task_list.at(taskVertex)->GetLane());
+			for (const size_t childUnit : child_units.at(unit))
+				lanes.at(unit) = std::min(lanes.at(unit), lanes.at(childUnit));
+		}
+		return lanes;
+	}
+
+	/**
+	 * \brief Checks which units may be deferred: all of their tasks and all of their descendants are deferrable.
+	 */
+	std::vector<bool> ComputeDeferrableUnits(const std::vector<CTaskScheduler::TExecutionUnit>& units,
+	                                         const std::vector<std::vector<size_t>>& child_units,
+	                                         const std::vector<std::shared_ptr<ITask>>& task_list)
+	{
+		std::vector<bool> deferrable(units.size(), false);
+		// the units are in topological order, so all children are computed before their parents
+		for (size_t unit = units.size(); unit-- > 0;)
+			deferrable.at(unit) = std::ranges::all_of(units.at(unit), [&](const size_t task_vertex)
+				{
+					return task_list.at(task_vertex)->IsDeferrable();
+				})
+				&& std::ranges::all_of(child_units.at(unit), [&](const size_t child_unit)
+				{
+					return deferrable.at(child_unit);
+				});
+		return deferrable;
+	}
+}
+
+CTaskScheduler::CTaskScheduler(const size_t num_workers, const size_t num_reserved_workers,
+                               const CCpuTopology* topology, const std::filesystem::path& cost_database_path)
+	: pOwnedWorkerPool(std::make_unique<CWorkerPool>(num_workers, num_reserved_workers, topology)),
+	  executor(*pOwnedWorkerPool),
+	  resourceContention(executor)
+{
+	LoadCostDatabase(cost_database_path);
+}
+
+CTaskScheduler::CTaskScheduler(ITaskExecutor& executor, const std::filesystem::path& cost_database_path)
+	: executor(executor),
+	  resourceContention(executor)
+{
+	LoadCostDatabase(cost_database_path);
+}
+
+CTaskScheduler::~CTaskScheduler()
+{
+	// no batch is running anymore, the calling thread waited for all of them
+	if (pOwnedCostDatabase)
+		pOwnedCostDatabase->Save(costDatabasePath);
+}
+
 void CTaskScheduler::OrderAndExecuteTasks(std::queue<std::shared_ptr<ITask>> task_queue)
 {
+	// nothing is deferred without a budget
+	OrderAndExecuteTasks(std::move(task_queue), TCost::max());
+}
+
+std::queue<std::shared_ptr<ITask>> CTaskScheduler::OrderAndExecuteTasks(
+	std::queue<std::shared_ptr<ITask>> task_queue, const TCost time_budget)
+{
+	const auto frameStart = std::chrono::steady_clock::now();
+	// the carry-over of the last batch may still consume its results
+	if (stats.numDeferredTasks == 0)
+		resultArena.Reset();
+
 	// build task flow with entt
 	entt::flow builder{};
 
@@ -25,73 +141,624 @@ void CTaskScheduler::OrderAndExecuteTasks(std::queue<std::shared_ptr<ITask>> tas
 	{
 		taskList.push_back(std::move(task_queue.front()));
 		task_queue.pop();
+	}
+	ApplyDatabaseCosts(taskList);
 
-		auto task = taskList.back();
-		task->AddTaskToBuilder(builder);
+	// accesses to whole objects are ordered against the accesses to their members
+	const CResourceHierarchy resourceHierarchy(taskList);
+	if (lockModeThreshold > 0 && taskList.size() <= lockModeThreshold)
+	{
+		ExecuteWithLocks(taskList, resourceHierarchy, frameStart);
+		return {};
 	}
 
-	// build taskQueue main
-	std::queue<size_t> scheduledTasks;
+	uint64_t accessesHash = ACCESSES_HASH_BASIS;
+	for (auto&& task : taskList)
+	{
+		task->AddTaskToBuilder(builder);
+		const std::vector<Meta::CResourceAccessInfo>& resources = task->GetResourceAccessInfos();
+		resourceHierarchy.RegisterImpliedResources(builder, resources);
+		// the resources were just read by the builder, so hashing them is almost free
+		if (contentionCounters)
+			for (const Meta::CResourceAccessInfo& resource : resources)
+				accessesHash = HashAccess(accessesHash, resource);
+	}
+	// before building the graph, its matrix would push the accesses out of the cache
+	if (contentionCounters)
+	{
+		resourceContention.BeginFrame();
+		CountResourceEdges(taskList, resourceHierarchy, accessesHash);
+	}
 
-	// get first tasks
 	const entt::adjacency_matrix<entt::directed_tag> graph = builder.graph();
-	for (size_t&& vertex : graph.vertices())
-		// vertex has no in_edges this means that this vertex is a main vertex
-		if (auto inEdges = graph.in_edges(vertex); inEdges.begin() == inEdges.end())
-			scheduledTasks.push(vertex);
-
-	using TReserved = bool; // to reserve a spot in the executedTasks vector
-	// hold references to all async threads until this vector goes out of scope
-	std::vector<std::pair<TReserved,TAsyncTaskPtr>> executedTasks(graph.size());
-	// execute all tasks in a certain order
-	while (!scheduledTasks.empty())
-	{
-		// get current task and remove from queue
-		const size_t taskVertex = scheduledTasks.front();
-		scheduledTasks.pop();
-
-		TAsyncTaskPtr pFuture = std::make_shared<TAsyncTask>();
-
-		// save reference to std::future beyond this while loop
-		executedTasks.at(taskVertex) = {true, pFuture};
-		// list of async threads from parents, moved into lambda capture
-		std::deque<std::weak_ptr<TAsyncTask>> parentTasks;
-		for (auto&& [parent, child] : graph.in_edges(taskVertex))
-			if (const auto& pParentFuture = executedTasks.at(parent).second)
-				parentTasks.emplace_back(pParentFuture);
-
-		// start async thread to do the work, thread is managed by OS
-		*pFuture = std::async(
-			std::launch::async,
-			[pTask = taskList.at(taskVertex).get(), parentTasks = std::move(parentTasks)]()
-			{
-				// wait for all parent tasks
-				for (auto&& pParentTask : parentTasks)
-					if (const auto& pParentFuture = pParentTask.lock())
-						pParentFuture->wait();
+	TTaskEdges taskParents(graph.size());
+	TTaskEdges taskChildren(graph.size());
+	for (size_t taskVertex = 0; taskVertex < graph.size(); ++taskVertex)
+		for (auto&& [parent, child] : graph.out_edges(taskVertex))
+		{
+			taskChildren.at(parent).push_back(child);
+			taskParents.at(child).push_back(parent);
+		}
+
+	std::queue<std::shared_ptr<ITask>> carryOverQueue =
+		ExecuteGraph(taskList, taskParents, taskChildren, frameStart, time_budget);
+	if (contentionCounters)
+		resourceContention.EndFrame();
+	return carryOverQueue;
+}
+
+void CTaskScheduler::OrderAndExecuteTasks(const CIncrementalTaskGraph& task_graph)
+{
+	// nothing is deferred without a budget
+	OrderAndExecuteTasks(task_graph, TCost::max());
+}
+
+std::queue<std::shared_ptr<ITask>> CTaskScheduler::OrderAndExecuteTasks(const CIncrementalTaskGraph& task_graph,
+                                                                        const TCost time_budget)
+{
+	const auto frameStart = std::chrono::steady_clock::now();
+	// the carry-over of the last batch may still consume its results
+	if (stats.numDeferredTasks == 0)
+		resultArena.Reset();
+
+	// only refreshes the task list and the edges, if the graph was updated since the last batch
+	const std::vector<std::shared_ptr<ITask>>& taskList = task_graph.GetTasks();
+	ApplyDatabaseCosts(taskList);
+
+	if (contentionCounters)
+	{
+		resourceContention.BeginFrame();
+		task_graph.VisitResourceEdges([this](const Meta::CResourceAccessInfo& resource, const size_t num_edges)
+		{
+			resourceContention.AddEdges(resource, num_edges);
+		});
+	}
+	std::queue<std::shared_ptr<ITask>> carryOverQueue =
+		ExecuteGraph(taskList, task_graph.GetParents(), task_graph.GetChildren(), frameStart, time_budget);
+	if (contentionCounters)
+		resourceContention.EndFrame();
+	return carryOverQueue;
+}
+
+void CTaskScheduler::LoadCostDatabase(const std::filesystem::path& cost_database_path)
+{
+	if (cost_database_path.empty())
+		return;
+	costDatabasePath = cost_database_path;
+	pOwnedCostDatabase = std::make_unique<CTaskCostDatabase>();
+	// a missing or outdated file only means starting without measured costs
+	pOwnedCostDatabase->Load(costDatabasePath);
+	pCostDatabase = pOwnedCostDatabase.get();
+}
+
+void CTaskScheduler::ApplyDatabaseCosts(const std::vector<std::shared_ptr<ITask>>& task_list) const
+{
+	if (!pCostDatabase)
+		return;
+	// the average of previous runs, so fusion and priorities do not depend on the last measurement only
+	for (auto&& task : task_list)
+		if (const std::optional<TCost> cost = pCostDatabase->GetCost(*task))
+			task->SetMeasuredCost(*cost);
+}
+
+uint64_t CTaskScheduler::HashAccess(const uint64_t accesses_hash, const Meta::CResourceAccessInfo& resource)
+{
+	// FNV-1a over the resources and access modes
+	constexpr uint64_t prime = 0x100000001b3;
+	const uint64_t hash = (accesses_hash ^ static_cast<uint64_t>(resource.hashCode)) * prime;
+	return (hash ^ static_cast<uint64_t>(resource.accessMode)) * prime;
+}
+
+void CTaskScheduler::CountResourceEdges(const std::vector<std::shared_ptr<ITask>>& task_list,
+                                        const CResourceHierarchy& resource_hierarchy, const uint64_t accesses_hash)
+{
+	// the implied accesses follow from the own ones
+	if (countedAccessesHash != accesses_hash)
+	{
+		for (auto&& task : task_list)
+		{
+			const std::vector<Meta::CResourceAccessInfo>& resources = task->GetResourceAccessInfos();
+			for (const Meta::CResourceAccessInfo& resource : resources)
+				CountResourceAccess(resource.hashCode, &resource, resource.accessMode == Meta::EResourceAccessMode::WRITE);
+			resource_hierarchy.VisitImpliedResources(resources,
+				[this](const size_t member, const Meta::EResourceAccessMode access_mode)
+				{
+					CountResourceAccess(member, nullptr, access_mode == Meta::EResourceAccessMode::WRITE);
+				});
+		}
+
+		countedEdges.clear();
+		for (const CUsedChain& usedChain : usedChains)
+		{
+			CCountedChain& chain = countedChains.at(usedChain.slot);
+			if (chain.numEdges > 0 && usedChain.pResource)
+				countedEdges.push_back({*usedChain.pResource, chain.numEdges});
+			chain = CCountedChain{};
+		}
+		usedChains.clear();
+		countedAccessesHash = accesses_hash;
+	}
+
+	for (const CCountedEdges& edges : countedEdges)
+		resourceContention.AddEdges(edges.resource, edges.numEdges);
+}
+
+void CTaskScheduler::CountResourceAccess(const size_t hash_code, const Meta::CResourceAccessInfo* resource,
+                                         const bool write)
+{
+	// doubles the table, once the next chain would fill more than half of it
+	if (2 * (usedChains.size() + 1) > countedChains.size())
+	{
+		std::vector<CCountedChain> chains(std::max<size_t>(countedChains.size() * 2, 64));
+		for (CUsedChain& usedChain : usedChains)
+		{
+			const CCountedChain& chain = countedChains.at(usedChain.slot);
+			usedChain.slot = Meta::GetResourceSlot(chain.hashCode, chains.size());
+			while (chains.at(usedChain.slot).usedIdx != 0)
+				usedChain.slot = (usedChain.slot + 1) & (chains.size() - 1);
+			chains.at(usedChain.slot) = chain;
+		}
+		countedChains = std::move(chains);
+	}
+
+	size_t chainSlot = Meta::GetResourceSlot(hash_code, countedChains.size());
+	while (countedChains.at(chainSlot).usedIdx != 0 && countedChains.at(chainSlot).hashCode != hash_code)
+		chainSlot = (chainSlot + 1) & (countedChains.size() - 1);
+	CCountedChain& chain = countedChains.at(chainSlot);
+	if (chain.usedIdx == 0)
+	{
+		chain.hashCode = hash_code;
+		usedChains.push_back({chainSlot, resource});
+		chain.usedIdx = static_cast<uint32_t>(usedChains.size());
+	}
+	else if (resource && !usedChains.at(chain.usedIdx - 1).pResource)
+		usedChains.at(chain.usedIdx - 1).pResource = resource;
+	// a writer waits for the readers since the last writer, or for the last writer,
+	// a reader waits for the last writer
+	if (write)
+	{
+		chain.numEdges += chain.numReaders > 0 ? chain.numReaders : chain.hasWriter ? 1 : 0;
+		chain.hasWriter = true;
+		chain.numReaders = 0;
+		return;
+	}
+	chain.numEdges += chain.hasWriter ? 1 : 0;
+	++chain.numReaders;
+}
+
+std::queue<std::shared_ptr<ITask>> CTaskScheduler::ExecuteGraph(const std::vector<std::shared_ptr<ITask>>& task_list,
+                                                                const TTaskEdges& task_parents,
+                                                                const TTaskEdges& task_children,
+                                                                const std::chrono::steady_clock::time_point frame_start,
+                                                                const TCost time_budget)
+{
+	// the units are in topological order, so all parents are started before their children
+	const std::vector<TExecutionUnit> executionUnits = FuseTasks(task_parents, task_children, task_list);
+	stats.numTasks = task_list.size();
+	stats.numExecutionUnits = executionUnits.size();
+	stats.lockMode = false;
+	stats.numLockWaits = 0;
 
-				// finally do the task
-				pTask->DoTask();
+	const size_t numUnits = executionUnits.size();
+	std::vector<size_t> unitOfTask(task_list.size());
+	for (size_t unit = 0; unit < numUnits; ++unit)
+		for (const size_t taskVertex : executionUnits.at(unit))
+			unitOfTask.at(taskVertex) = unit;
+
+	// dependencies between the units
+	std::vector<std::vector<size_t>> childUnits(numUnits);
+	std::vector<size_t> numPendingParents(numUnits, 0);
+	for (size_t unit = 0; unit < numUnits; ++unit)
+	{
+		std::vector<size_t> parentUnits;
+		for (const size_t taskVertex : executionUnits.at(unit))
+			for (const size_t parent : task_parents.at(taskVertex))
+				if (const size_t parentUnit = unitOfTask.at(parent);
+					parentUnit != unit && std::ranges::find(parentUnits, parentUnit) == parentUnits.end())
+				{
+					parentUnits.push_back(parentUnit);
+					childUnits.at(parentUnit).push_back(unit);
+				}
+		numPendingParents.at(unit) = parentUnits.size();
+	}
+
+	const std::vector<TCost> priorities = ComputeBottomLevels(executionUnits, childUnits, task_list);
+	stats.criticalPathCost = priorities.empty() ? TCost::zero() : *std::ranges::max_element(priorities);
+
+	const std::vector<ETaskLane> lanes = ComputeUnitLanes(executionUnits, childUnits, task_list);
+	const std::vector<bool> deferrable = ComputeDeferrableUnits(executionUnits, childUnits, task_list);
+	// tasks of a unit share their node hint
+	std::vector<size_t> nodeHints(numUnits);
+	for (size_t unit = 0; unit < numUnits; ++unit)
+		nodeHints.at(unit) = task_list.at(executionUnits.at(unit).front())->GetNodeHint();
+	// units not started because of the budget, their children are deferred as well
+	std::vector<bool> deferred(numUnits, false);
+	std::vector<bool> hasDeferredParent(numUnits, false);
+
+	auto hasLowerPriority = [&priorities](const size_t unit_a, const size_t unit_b)
+	{
+		// on equal priority the unit queued first is started first
+		if (priorities.at(unit_a) != priorities.at(unit_b))
+			return priorities.at(unit_a) < priorities.at(unit_b);
+		return unit_a > unit_b;
+	};
+	using TReadyQueue = std::priority_queue<size_t, std::vector<size_t>, decltype(hasLowerPriority)>;
+	// ready units per lane, every job of the pool starts the ready unit of its lane with the highest priority,
+	// not necessarily the one which became ready when the job was enqueued (unless the units are placed by affinity)
+	std::mutex readyMutex;
+	std::vector<TReadyQueue> readyUnits(NUM_LANES, TReadyQueue(hasLowerPriority));
+	size_t numUnfinishedUnits = numUnits;
+
+	// workers are starved while no unit is ready and fewer units than workers are running,
+	// their idle time is counted for the resources of the running units, which the ready ones wait for
+	const size_t numWorkers = executor.GetNumWorkers();
+	size_t numQueuedUnits = 0;
+	size_t numRunningUnits = 0;
+	// starved time counted for every running unit since the batch started,
+	// a unit gets the increase while it was running, so the ready mutex is never held for a loop over the units
+	TCost runningStarvedTime = TCost::zero();
+	std::vector<TCost> unitStartStarvedTimes(contentionCounters ? numUnits : 0);
+	// start of the current starving interval
+	std::chrono::steady_clock::time_point lastRunningChange;
+	auto isStarving = [&]()
+	{
+		return numQueuedUnits == 0 && numRunningUnits > 0 && numRunningUnits < numWorkers;
+	};
+	// called with the ready mutex held around changing the queued or running units,
+	// the clock is only read while workers are starving, so a busy batch does not pay for it
+	auto countStarvedTime = [&](auto&& change_units)
+	{
+		const bool wasStarving = isStarving();
+		const size_t numStarvedWorkers = numWorkers - numRunningUnits;
+		change_units();
+		if (!wasStarving && !isStarving())
+			return;
+		const auto now = std::chrono::steady_clock::now();
+		if (wasStarving)
+			runningStarvedTime += std::chrono::duration_cast<TCost>(now - lastRunningChange)
+				* static_cast<TCost::rep>(numStarvedWorkers);
+		lastRunningChange = now;
+	};
+
+	// resources of every unit for placing it on the worker which last wrote them
+	std::vector<std::vector<Meta::CResourceAccessInfo>> unitResources(resourceAffinity ? numUnits : 0);
+	for (size_t unit = 0; unit < unitResources.size(); ++unit)
+		for (const size_t taskVertex : executionUnits.at(unit))
+		{
+			const std::vector<Meta::CResourceAccessInfo>& taskResources = task_list.at(taskVertex)->GetResourceAccessInfos();
+			unitResources.at(unit).insert(unitResources.at(unit).end(), taskResources.begin(), taskResources.end());
+		}
+
+	std::function<void(size_t)> executeUnit;
+	std::function<void(size_t, bool)> finishUnit;
+	// starts the ready unit of the lane with the highest priority
+	auto executeReadyUnit = [&](const ETaskLane lane)
+	{
+		size_t unit = 0;
+		{
+			std::scoped_lock lock(readyMutex);
+			TReadyQueue& laneUnits = readyUnits.at(static_cast<size_t>(lane));
+			unit = laneUnits.top();
+			laneUnits.pop();
+		}
+		executeUnit(unit);
+	};
+
+	auto enqueueReadyUnits = [&](std::vector<size_t> ready_units)
+	{
+		// placed units are bound to their jobs, the worker starts the last enqueued one first,
+		// so at least units becoming ready together keep their priority order
+		std::ranges::sort(ready_units, hasLowerPriority);
+		std::vector<size_t> sharedUnits;
+		for (const size_t unit : ready_units)
+		{
+			if (resourceAffinity)
+				executor.EnqueueWithAffinity([&executeUnit, unit] { executeUnit(unit); },
+				                               unitResources.at(unit), lanes.at(unit), nodeHints.at(unit));
+			else if (nodeHints.at(unit) != CCpuTopology::NO_NODE)
+				executor.EnqueueOnNode([&executeUnit, unit] { executeUnit(unit); }, nodeHints.at(unit), lanes.at(unit));
+			else
+				sharedUnits.push_back(unit);
+		}
+
+		{
+			std::scoped_lock lock(readyMutex);
+			for (const size_t unit : sharedUnits)
+				readyUnits.at(static_cast<size_t>(lanes.at(unit))).push(unit);
+		}
+		for (const size_t unit : sharedUnits)
+		{
+			const ETaskLane lane = lanes.at(unit);
+			executor.Enqueue([&executeReadyUnit, lane] { executeReadyUnit(lane); }, lane);
+		}
+	};
+
+	executeUnit = [&](const size_t unit)
+	{
+		bool deferUnit = false;
+		{
+			std::scoped_lock lock(readyMutex);
+			deferUnit = hasDeferredParent.at(unit);
+			if (contentionCounters)
+			{
+				countStarvedTime([&]
+				{
+					--numQueuedUnits;
+					++numRunningUnits;
+				});
+				unitStartStarvedTimes.at(unit) = runningStarvedTime;
 			}
-		);
+		}
 
-		// add all children of current vertex to the task queue
-		for (auto&& [parent, child] : graph.out_edges(taskVertex))
+		// the frame would take longer than the budget, if the unit is started now
+		if (!deferUnit && deferrable.at(unit) && time_budget != TCost::max())
+		{
+			const TCost elapsedTime = std::chrono::duration_cast<TCost>(std::chrono::steady_clock::now() - frame_start);
+			deferUnit = elapsedTime + priorities.at(unit) > time_budget;
+		}
+
+		if (deferUnit)
+			finishUnit(unit, true);
+		else
+			ExecuteUnit(executionUnits.at(unit), task_list, [&finishUnit, unit] { finishUnit(unit, false); });
+	};
+
+	// releases the children, possibly after a suspended task completed on another worker
+	finishUnit = [&](const size_t unit, const bool defer_unit)
+	{
+		std::vector<size_t> readyChildren;
+		TCost starvedTime = TCost::zero();
 		{
-			// if the task hasn't been reserved yet, we add it to the scheduled list
-			if (!executedTasks.at(child).first)
+			std::scoped_lock lock(readyMutex);
+			deferred.at(unit) = defer_unit;
+			for (const size_t childUnit : childUnits.at(unit))
 			{
-				// reserve the spot, so it won't get taken multiple times
-				executedTasks.at(child).first = true;
-				scheduledTasks.push(child);
+				hasDeferredParent.at(childUnit) = hasDeferredParent.at(childUnit) || defer_unit;
+				if (--numPendingParents.at(childUnit) == 0)
+					readyChildren.push_back(childUnit);
 			}
+			if (contentionCounters)
+			{
+				countStarvedTime([&]
+				{
+					--numRunningUnits;
+					numQueuedUnits += readyChildren.size();
+				});
+				starvedTime = runningStarvedTime - unitStartStarvedTimes.at(unit);
+			}
+		}
+		if (starvedTime > TCost::zero())
+			for (const size_t taskVertex : executionUnits.at(unit))
+				for (const Meta::CResourceAccessInfo& resource : task_list.at(taskVertex)->GetResourceAccessInfos())
+					resourceContention.AddStarvedTime(resource, starvedTime);
+		enqueueReadyUnits(std::move(readyChildren));
+
+		// last access to the state of the batch, it may be gone right after
+		std::scoped_lock lock(readyMutex);
+		if (--numUnfinishedUnits == 0)
+			executor.NotifyHelpers();
+	};
+
+	std::vector<size_t> rootUnits;
+	for (size_t unit = 0; unit < numUnits; ++unit)
+		if (numPendingParents.at(unit) == 0)
+			rootUnits.push_back(unit);
+	stats.graphBuildTime = std::chrono::duration_cast<TCost>(std::chrono::steady_clock::now() - frame_start);
+	numQueuedUnits = rootUnits.size();
+	enqueueReadyUnits(std::move(rootUnits));
+
+	// help executing the units, so in the next tick the script-thread doesn't start
+	// before the last unit has finished execution
+	executor.HelpUntil([&]()
+	{
+		std::scoped_lock lock(readyMutex);
+		return numUnfinishedUnits == 0;
+	});
+
+	// hand back the deferred tasks in queue order
+	std::vector<size_t> deferredTasks;
+	for (size_t unit = 0; unit < numUnits; ++unit)
+		if (deferred.at(unit))
+			deferredTasks.insert(deferredTasks.end(), executionUnits.at(unit).begin(), executionUnits.at(unit).end());
+	std::ranges::sort(deferredTasks);
+	stats.numDeferredTasks = deferredTasks.size();
+
+	std::queue<std::shared_ptr<ITask>> carryOverQueue;
+	for (const size_t taskVertex : deferredTasks)
+		carryOverQueue.push(task_list.at(taskVertex));
+	return carryOverQueue;
+}
+
+void CTaskScheduler::ExecuteUnit(const TExecutionUnit& unit, const std::vector<std::shared_ptr<ITask>>& task_list,
+                                 ITask::TCompletion&& on_finished) const
+{
+	// asynchronous tasks are never fused, traced ones are executed synchronously
+	if (unit.size() == 1 && task_list.at(unit.front())->IsAsync() && !pAccessTracer)
+	{
+		ITask& task = *task_list.at(unit.front());
+		const auto start = std::chrono::steady_clock::now();
+		// the cost includes the time the task was suspended, it is on the path of its dependents all the same
+		task.StartAsync([this, &task, start, onFinished = std::move(on_finished)]
+		{
+			const auto cost = std::chrono::duration_cast<TCost>(std::chrono::steady_clock::now() - start);
+			task.SetMeasuredCost(cost);
+			if (pCostDatabase)
+				pCostDatabase->Record(task, cost);
+			onFinished();
+		});
+		return;
+	}
+
+	// fused tasks are already in dependency order
+	for (const size_t taskVertex : unit)
+	{
+		ITask& task = *task_list.at(taskVertex);
+		const auto start = std::chrono::steady_clock::now();
+		if (pAccessTracer)
+			pAccessTracer->TraceTask(task);
+		else
+			task.DoTask();
+		const auto cost = std::chrono::duration_cast<TCost>(std::chrono::steady_clock::now() - start);
+		task.SetMeasuredCost(cost);
+		// traced executions are slower and would distort the averages
+		if (pCostDatabase && !pAccessTracer)
+			pCostDatabase->Record(task, cost);
+	}
+	on_finished();
+}
+
+void CTaskScheduler::ExecuteWithLocks(const std::vector<std::shared_ptr<ITask>>& task_list,
+                                      const CResourceHierarchy& resource_hierarchy,
+                                      const std::chrono::steady_clock::time_point frame_start)
+{
+	const size_t numTasks = task_list.size();
+	stats = CStats{};
+	stats.numTasks = numTasks;
+	stats.numExecutionUnits = numTasks;
+	stats.lockMode = true;
+
+	// accesses to whole objects lock the members accessed in the batch as well,
+	// the lock sets are made in queue order, which is the order conflicting tasks get their locks in
+	std::vector<CResourceLockTable::TLockSet> lockSets;
+	lockSets.reserve(numTasks);
+	for (auto&& task : task_list)
+	{
+		std::vector<Meta::CResourceAccessInfo> resources = task->GetResourceAccessInfos();
+		resource_hierarchy.VisitImpliedResources(task->GetResourceAccessInfos(),
+			[&resources](const size_t member, const Meta::EResourceAccessMode access_mode)
+			{
+				Meta::CResourceAccessInfo implied{};
+				implied.hashCode = member;
+				implied.accessMode = access_mode;
+				resources.push_back(implied);
+			});
+		lockSets.push_back(lockTable.MakeLockSet(resources));
+	}
+
+	// tasks waiting for a lock are started again once the stripe they wait for reached their turn,
+	// waiting never blocks a worker, which might be needed to finish the task holding the lock
+	std::atomic<size_t> numLockWaits = 0;
+	std::atomic<size_t> numUnfinishedTasks = numTasks;
+
+	std::function<void(size_t)> startTask;
+	auto enqueueTask = [&](const size_t task_idx)
+	{
+		const ITask& task = *task_list.at(task_idx);
+		if (task.GetNodeHint() != CCpuTopology::NO_NODE)
+			executor.EnqueueOnNode([&startTask, task_idx] { startTask(task_idx); }, task.GetNodeHint(), task.GetLane());
+		else
+			executor.Enqueue([&startTask, task_idx] { startTask(task_idx); }, task.GetLane());
+	};
+
+	startTask = [&](const size_t task_idx)
+	{
+		if (!lockTable.LockOrWait(lockSets.at(task_idx), task_idx))
+		{
+			numLockWaits.fetch_add(1);
+			return;
+		}
+
+		ExecuteUnit({task_idx}, task_list, [&, task_idx]
+		{
+			std::vector<size_t> wokenTasks;
+			lockTable.Unlock(lockSets.at(task_idx), wokenTasks);
+			for (const size_t wokenTask : wokenTasks)
+				enqueueTask(wokenTask);
+			// last access to the state of the batch, it may be gone right after
+			ITaskExecutor& batchExecutor = executor;
+			if (numUnfinishedTasks.fetch_sub(1) == 1)
+				batchExecutor.NotifyHelpers();
+		});
+	};
+
+	stats.graphBuildTime = std::chrono::duration_cast<TCost>(std::chrono::steady_clock::now() - frame_start);
+	// in queue order, so the tasks whose turn comes first rarely have to wait
+	for (size_t taskIdx = 0; taskIdx < numTasks; ++taskIdx)
+		enqueueTask(taskIdx);
+	executor.HelpUntil([&numUnfinishedTasks] { return numUnfinishedTasks.load() == 0; });
+	stats.numLockWaits = numLockWaits.load();
+}
+
+std::vector<CTaskScheduler::TExecutionUnit> CTaskScheduler::FuseTasks(
+	const TTaskEdges& task_parents, const TTaskEdges& task_children,
+	const std::vector<std::shared_ptr<ITask>>& task_list) const
+{
+	// vertices are numbered in queue order, all edges point from a lower to a higher index
+	const size_t numTasks = task_list.size();
+	std::vector<TExecutionUnit> units;
+	std::vector<TCost> unitCosts;
+	std::vector<size_t> unitOfTask(numTasks);
+
+	auto getCost = [&](const size_t task_vertex)
+	{
+		return task_list.at(task_vertex)->GetCost().value_or(TCost::zero());
+	};
+	// tasks without any known cost are never fused, asynchronous ones would block the rest of their unit
+	auto isTiny = [&](const size_t task_vertex)
+	{
+		const std::optional<TCost> cost = task_list.at(task_vertex)->GetCost();
+		return fusionThreshold > TCost::zero() && cost && *cost <= fusionThreshold && !task_list.at(task_vertex)->IsAsync();
+	};
+
+	// linear chains: a task with a single child whose only parent is that task
+	std::vector<bool> appendedToChain(numTasks, false);
+	for (size_t taskVertex = 0; taskVertex < numTasks; ++taskVertex)
+	{
+		if (!appendedToChain.at(taskVertex))
+		{
+			unitOfTask.at(taskVertex) = units.size();
+			units.push_back({taskVertex});
+			unitCosts.push_back(getCost(taskVertex));
+		}
+
+		const size_t unit = unitOfTask.at(taskVertex);
+		if (!isTiny(taskVertex) || task_children.at(taskVertex).size() != 1)
+			continue;
+		const size_t child = task_children.at(taskVertex).front();
+		if (!isTiny(child) || task_parents.at(child).size() != 1
+			|| task_list.at(child)->GetLane() != task_list.at(taskVertex)->GetLane()
+			|| task_list.at(child)->GetNodeHint() != task_list.at(taskVertex)->GetNodeHint()
+			|| unitCosts.at(unit) + getCost(child) > fusionThreshold)
+			continue;
+		appendedToChain.at(child) = true;
+		unitOfTask.at(child) = unit;
+		units.at(unit).push_back(child);
+		unitCosts.at(unit) += getCost(child);
+	}
+
+	// independent siblings: single task units with the same parent units, lane and node hint,
+	// identical parents imply that there is no path between them
+	std::map<std::tuple<ETaskLane, size_t, std::vector<size_t>>, size_t> siblingUnits;
+	for (size_t taskVertex = 0; taskVertex < numTasks; ++taskVertex)
+	{
+		const size_t unit = unitOfTask.at(taskVertex);
+		if (units.at(unit).size() != 1 || !isTiny(taskVertex))
+			continue;
+
+		std::vector<size_t> parentUnits;
+		for (const size_t parent : task_parents.at(taskVertex))
+			parentUnits.push_back(unitOfTask.at(parent));
+		std::ranges::sort(parentUnits);
+		const auto [first, last] = std::ranges::unique(parentUnits);
+		parentUnits.erase(first, last);
+
+		auto siblingKey = std::make_tuple(task_list.at(taskVertex)->GetLane(), task_list.at(taskVertex)->GetNodeHint(),
+		                                  std::move(parentUnits));
+		auto siblingUnit = siblingUnits.find(siblingKey);
+		if (siblingUnit == siblingUnits.end()
+			|| unitCosts.at(siblingUnit->second) + getCost(taskVertex) > fusionThreshold)
+		{
+			// start collecting siblings in the unit of this task
+			siblingUnits[std::move(siblingKey)] = unit;
+			continue;
 		}
+		units.at(unit).clear();
+		unitOfTask.at(taskVertex) = siblingUnit->second;
+		units.at(siblingUnit->second).push_back(taskVertex);
+		unitCosts.at(siblingUnit->second) += getCost(taskVertex);
 	}
 
-	// wait for all started threads,
-	// so in the next tick the script-thread doesn't start
-	// before the last async thread has finished execution
-	for (TAsyncTaskPtr& val : executedTasks | std::views::values)
-		if (val)
-			val->wait();
+	// units are ordered by their first task, which keeps them in topological order
+	std::erase_if(units, [](const TExecutionUnit& unit) { return unit.empty(); });
+	return units;
 }
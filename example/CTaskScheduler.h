@@ -1,22 +1,278 @@
 #pragma once
 
-#include <future>
+#include <cassert>
+#include <cstdint>
+#include <filesystem>
 #include <memory>
 #include <MetaResourceVisitor.hpp>
+#include <optional>
 #include <queue>
+#include <vector>
 
+#include "CAccessTracer.h"
+#include "CIncrementalTaskGraph.h"
+#include "CResourceContention.h"
+#include "CResourceLockTable.h"
+#include "CTaskCostDatabase.h"
+#include "CTaskResultArena.h"
+#include "CWorkerPool.h"
 #include "MetaResourceList.h"
 #include "Task.hpp"
 
+class CResourceHierarchy;
+
+/**
+ * \brief Builds the execution graph of a batch of tasks and executes it on the worker pool or another executor.
+ *        Ready tasks are started critical path first: the task with the most remaining work
+ *        on its longest path to the end of the batch (bottom level) is started first.
+ *        Tasks of a higher lane (see ITask::SetLane) are always started before those of lower lanes,
+ *        a task inherits the most urgent lane of the tasks waiting for it.
+ *        Tasks with a node hint (see ITask::SetNodeHint) are placed on a worker of that node.
+ */
 class CTaskScheduler
 {
 public:
-	using TAsyncTask = std::future<void>;
-	using TAsyncTaskPtr = std::shared_ptr<TAsyncTask>;
 	using TResourceVisitor = Meta::CResourceVisitor<Meta::TGlobalResourceList>;
+	using TCost = ITask::TCost;
+	// task indices of the batch, executed one after another by the same thread
+	using TExecutionUnit = std::vector<size_t>;
+	// parent or child task indices of every task of the batch
+	using TTaskEdges = std::vector<std::vector<size_t>>;
+
+	struct CStats
+	{
+		size_t numTasks = 0;
+		size_t numExecutionUnits = 0;
+		// cost of the longest dependency chain, the lower bound of the execution time of the batch
+		TCost criticalPathCost = TCost::zero();
+		// time from the call until the first task was started: building the graph, or the lock sets in lock mode
+		TCost graphBuildTime = TCost::zero();
+		// tasks handed back as carry-over batch
+		size_t numDeferredTasks = 0;
+		// the batch was executed with resource locks instead of a graph
+		bool lockMode = false;
+		// times a task of a lock mode batch found one of its locks taken and had to wait
+		size_t numLockWaits = 0;
+
+		// average number of tasks per execution unit, 1 if nothing was fused
+		double GetFusionRatio() const
+		{
+			return numExecutionUnits > 0 ? static_cast<double>(numTasks) / static_cast<double>(numExecutionUnits) : 1.0;
+		}
+	};
 
-	CTaskScheduler() = default;
-	~CTaskScheduler() = default;
+	/**
+	 * \param num_workers Number of worker threads executing the tasks and the chunks of parallel tasks
+	 * \param num_reserved_workers Number of workers only executing tasks of the high lane
+	 * \param topology Pins the workers to the CPUs of the topology, see CWorkerPool
+	 * \param cost_database_path File of the cost database of the scheduler, see SetCostDatabase.
+	 *        Loaded here and saved when the scheduler is destroyed, empty for no database
+	 */
+	explicit CTaskScheduler(size_t num_workers = std::thread::hardware_concurrency(), size_t num_reserved_workers = 0,
+	                        const CCpuTopology* topology = nullptr, const std::filesystem::path& cost_database_path = {});
+	/**
+	 * \param executor Existing executor the ready tasks are dispatched into, has to outlive the scheduler,
+	 *        e.g. a CInlineExecutor for reproducible runs
+	 * \param cost_database_path File of the cost database of the scheduler, see above
+	 */
+	explicit CTaskScheduler(ITaskExecutor& executor, const std::filesystem::path& cost_database_path = {});
+	// saves the own cost database
+	~CTaskScheduler();
 
+	/**
+	 * \brief Executes the tasks, conflicting tasks in queue order.
+	 *        The calling thread helps executing them and returns when all of them are finished.
+	 */
 	void OrderAndExecuteTasks(std::queue<std::shared_ptr<ITask>> task_queue);
+
+	/**
+	 * \brief Executes the tasks within a time budget.
+	 *        Deferrable tasks whose descendants are deferrable as well are not started,
+	 *        if the elapsed time plus their longest remaining path would exceed the budget.
+	 *        Their descendants are not started either.
+	 * \param task_queue The tasks of the frame, conflicting tasks are executed in queue order
+	 * \param time_budget Time budget of the frame, measured from the call
+	 * \return The deferred tasks in queue order, to be queued in front of the tasks of the next frame,
+	 *         so conflicting tasks keep their order
+	 */
+	std::queue<std::shared_ptr<ITask>> OrderAndExecuteTasks(std::queue<std::shared_ptr<ITask>> task_queue,
+	                                                        TCost time_budget);
+
+	/**
+	 * \brief Executes the tasks of a graph kept across frames, without building a graph.
+	 *        The calling thread helps executing them and returns when all of them are finished.
+	 *        The lock mode is not used, the graph is already there.
+	 */
+	void OrderAndExecuteTasks(const CIncrementalTaskGraph& task_graph);
+
+	/**
+	 * \brief Executes the tasks of a graph kept across frames within a time budget, see above.
+	 * \return The deferred tasks in task order, they stay in the graph
+	 */
+	std::queue<std::shared_ptr<ITask>> OrderAndExecuteTasks(const CIncrementalTaskGraph& task_graph, TCost time_budget);
+
+	// enables tracing of the declared write accesses, pass nullptr to disable it again
+	void SetAccessTracer(CAccessTracer* access_tracer) { pAccessTracer = access_tracer; }
+
+	/**
+	 * \brief Uses the averaged costs of the database for all tasks and records the measured costs into it,
+	 *        pass nullptr to disable it again. Declared costs still take precedence.
+	 *        Replaces the own database of the scheduler, which is still saved when the scheduler is destroyed.
+	 */
+	void SetCostDatabase(CTaskCostDatabase* cost_database) { pCostDatabase = cost_database; }
+	// the database used for the costs, nullptr if there is none
+	const CTaskCostDatabase* GetCostDatabase() const { return pCostDatabase; }
+
+	/**
+	 * \brief Enables the fusion of tiny tasks into one execution unit to cut the per-task overhead.
+	 *        Tasks with a declared or measured cost up to the threshold are fused
+	 *        along linear chains and with independent siblings, as long as the unit stays below the threshold.
+	 *        Zero disables the fusion.
+	 */
+	void SetFusionThreshold(const TCost threshold) { fusionThreshold = threshold; }
+
+	/**
+	 * \brief Places ready tasks on the worker which last wrote their resources, so the data is still in its cache.
+	 *        Placed tasks are bound to their worker, other workers only get them by stealing,
+	 *        so the critical path order is only kept among tasks becoming ready at the same time.
+	 *        See CWorkerPool::GetAffinityStats for the hit rate.
+	 */
+	void SetResourceAffinity(const bool resource_affinity) { resourceAffinity = resource_affinity; }
+
+	/**
+	 * \brief Counts the edges and the starved worker time every resource causes in the batches executed with a graph,
+	 *        see GetResourceContention. Enabled by default, it costs a hash of the accesses of the batch,
+	 *        a pass counting the edges only if they changed since the last batch,
+	 *        and a clock read for every started or finished unit while workers are starving, none while all are busy.
+	 */
+	void SetContentionCounters(const bool contention_counters) { contentionCounters = contention_counters; }
+
+	/**
+	 * \brief Executes batches of up to this number of tasks without building a graph:
+	 *        every task takes reader-writer locks on its resources before it runs (see CResourceLockTable).
+	 *        The locks are granted in queue order, so conflicting tasks run in queue order as in the graph,
+	 *        but the time budget is ignored. Zero disables the lock mode.
+	 */
+	void SetLockModeThreshold(const size_t num_tasks) { lockModeThreshold = num_tasks; }
+
+	// statistics of the last executed batch
+	const CStats& GetStats() const { return stats; }
+
+	/**
+	 * \brief Counters of the edges and the starved worker time every resource caused in the last batch executed with a graph,
+	 *        see CResourceContention::GetSnapshot. Not counted if disabled, the snapshot may be taken from any thread.
+	 */
+	const CResourceContention& GetResourceContention() const { return resourceContention; }
+
+	// executor of the tasks, also used for splitting up work inside of tasks, e.g. for CParallelTask
+	ITaskExecutor& GetExecutor() { return executor; }
+
+	// the pool created by the scheduler, only if it was not given an executor
+	CWorkerPool& GetWorkerPool()
+	{
+		assert(pOwnedWorkerPool && "The scheduler was given an executor.");
+		return *pOwnedWorkerPool;
+	}
+
+	/**
+	 * \brief Storage for the results passed between tasks, e.g. for CDataflowTask.
+	 *        The results stay valid until the next batch starts,
+	 *        unless the last batch deferred tasks, which may still consume them.
+	 */
+	CTaskResultArena& GetResultArena() { return resultArena; }
+
+private:
+	CAccessTracer* pAccessTracer = nullptr;
+	CTaskCostDatabase* pCostDatabase = nullptr;
+	// only if the scheduler was given a database path
+	std::unique_ptr<CTaskCostDatabase> pOwnedCostDatabase;
+	std::filesystem::path costDatabasePath;
+	TCost fusionThreshold = TCost::zero();
+	bool resourceAffinity = false;
+	bool contentionCounters = true;
+	size_t lockModeThreshold = 0;
+	CResourceLockTable lockTable;
+	CStats stats;
+	CTaskResultArena resultArena;
+	// declared after the arena, so the own workers are joined before the results are destroyed
+	std::unique_ptr<CWorkerPool> pOwnedWorkerPool;
+	ITaskExecutor& executor;
+	// one shard per worker and one for the calling thread
+	CResourceContention resourceContention;
+
+	// state of the chain of a resource while counting the accesses of the batch in queue order,
+	// small, so the table of a batch with thousands of resources stays in the cache
+	struct CCountedChain
+	{
+		size_t hashCode = 0;
+		// index in the used chains plus one, zero for an empty slot
+		uint32_t usedIdx = 0;
+		uint32_t numReaders = 0;
+		uint32_t numEdges = 0;
+		bool hasWriter = false;
+	};
+
+	struct CUsedChain
+	{
+		size_t slot = 0;
+		// an own access describing the resource, implied accesses have none
+		const Meta::CResourceAccessInfo* pResource = nullptr;
+	};
+
+	struct CCountedEdges
+	{
+		Meta::CResourceAccessInfo resource;
+		size_t numEdges = 0;
+	};
+
+	// open-addressing table of the chains, at most half full, empty between batches
+	// and kept for the next one, so counting does not allocate once the batches stop growing
+	std::vector<CCountedChain> countedChains;
+	std::vector<CUsedChain> usedChains;
+	// edges of the last counted batch, copies of the resources, as its tasks may be gone
+	std::vector<CCountedEdges> countedEdges;
+	// hash of the accesses of the last counted batch, a batch repeating them has the same edges
+	std::optional<uint64_t> countedAccessesHash;
+
+	// creates the own cost database and loads the file, if there is a path
+	void LoadCostDatabase(const std::filesystem::path& cost_database_path);
+	// uses the averaged costs of the cost database for the tasks
+	void ApplyDatabaseCosts(const std::vector<std::shared_ptr<ITask>>& task_list) const;
+	static constexpr uint64_t ACCESSES_HASH_BASIS = 0xcbf29ce484222325;
+	// hashes the access to the resource into the hash of the accesses of a batch, which starts at ACCESSES_HASH_BASIS
+	static uint64_t HashAccess(uint64_t accesses_hash, const Meta::CResourceAccessInfo& resource);
+	/**
+	 * \brief Counts the edges every resource creates in the graph of the batch,
+	 *        the same ones entt::flow creates before removing the transitive ones.
+	 *        Games mostly execute the same batch every frame, so the edges are only counted again,
+	 *        if the accesses of the batch changed since the last counted one.
+	 * \param task_list The batch
+	 * \param resource_hierarchy Implied accesses of the batch
+	 * \param accesses_hash Hash of the own accesses of the batch in queue order, see HashAccess
+	 */
+	void CountResourceEdges(const std::vector<std::shared_ptr<ITask>>& task_list,
+	                        const CResourceHierarchy& resource_hierarchy, uint64_t accesses_hash);
+	// adds the edge of the access to the chain of its resource
+	void CountResourceAccess(size_t hash_code, const Meta::CResourceAccessInfo* resource, bool write);
+	/**
+	 * \brief Executes the tasks of a batch along its edges, all edges point from a lower to a higher task index.
+	 * \return The deferred tasks in task order
+	 */
+	std::queue<std::shared_ptr<ITask>> ExecuteGraph(const std::vector<std::shared_ptr<ITask>>& task_list,
+	                                                const TTaskEdges& task_parents, const TTaskEdges& task_children,
+	                                                std::chrono::steady_clock::time_point frame_start,
+	                                                TCost time_budget);
+	// groups the tasks into execution units in topological order, without fusion every task is its own unit
+	std::vector<TExecutionUnit> FuseTasks(const TTaskEdges& task_parents, const TTaskEdges& task_children,
+	                                      const std::vector<std::shared_ptr<ITask>>& task_list) const;
+	/**
+	 * \brief Executes the tasks of the unit one after another, measuring their costs.
+	 *        An asynchronous task is only started, on_finished is called once it is complete.
+	 */
+	void ExecuteUnit(const TExecutionUnit& unit, const std::vector<std::shared_ptr<ITask>>& task_list,
+	                 ITask::TCompletion&& on_finished) const;
+	// starts every task as soon as it holds the locks of its resources, returns when all of them are finished
+	void ExecuteWithLocks(const std::vector<std::shared_ptr<ITask>>& task_list,
+	                      const CResourceHierarchy& resource_hierarchy,
+	                      std::chrono::steady_clock::time_point frame_start);
 };
@@ -0,0 +1,50 @@
+#include "CTaskTimer.h"
+
+CTaskTimer::CTaskTimer()
+	: thread([this] { TimerLoop(); })
+{
+}
+
+CTaskTimer::~CTaskTimer()
+{
+	{
+		std::scoped_lock lock(mutex);
+		stop = true;
+	}
+	condition.notify_one();
+	thread.join();
+}
+
+void CTaskTimer::CallAt(const TClock::time_point deadline, TCallback&& callback)
+{
+	{
+		std::scoped_lock lock(mutex);
+		entries.emplace(deadline, std::move(callback));
+	}
+	// the new deadline might be earlier than the one the thread waits for
+	condition.notify_one();
+}
+
+void CTaskTimer::TimerLoop()
+{
+	std::unique_lock lock(mutex);
+	while (!stop)
+	{
+		if (entries.empty())
+		{
+			condition.wait(lock);
+			continue;
+		}
+		if (TClock::now() < entries.top().first)
+		{
+			condition.wait_until(lock, entries.top().first);
+			continue;
+		}
+
+		TCallback callback = std::move(const_cast<TEntry&>(entries.top()).second);
+		entries.pop();
+		lock.unlock();
+		callback();
+		lock.lock();
+	}
+}
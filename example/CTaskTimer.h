@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "CTaskCoroutine.h"
+
+/**
+ * \brief Timer thread for coroutine tasks: a sleeping task suspends and releases its worker,
+ *        the timer resumes it on the pool once the duration passed.
+ */
+class CTaskTimer
+{
+public:
+	using TClock = std::chrono::steady_clock;
+	using TCallback = std::function<void()>;
+
+	CTaskTimer();
+	// drops the pending callbacks, no task may still sleep on the timer
+	~CTaskTimer();
+
+	CTaskTimer(const CTaskTimer&) = delete;
+	CTaskTimer& operator=(const CTaskTimer&) = delete;
+
+	// calls the callback on the timer thread at the deadline, callbacks should only hand over work
+	void CallAt(TClock::time_point deadline, TCallback&& callback);
+
+	/**
+	 * \brief Suspends the calling coroutine task for the duration, its worker continues with other tasks meanwhile.
+	 */
+	auto SleepFor(const TClock::duration duration)
+	{
+		struct CAwaiter
+		{
+			CTaskTimer& timer;
+			TClock::time_point deadline;
+
+			bool await_ready() const { return TClock::now() >= deadline; }
+
+			void await_suspend(const CTaskCoroutine::THandle handle)
+			{
+				timer.CallAt(deadline, [handle] { handle.promise().ResumeOnExecutor(); });
+			}
+
+			void await_resume() const {}
+		};
+		return CAwaiter{*this, TClock::now() + duration};
+	}
+
+private:
+	using TEntry = std::pair<TClock::time_point, TCallback>;
+
+	struct CLaterDeadline
+	{
+		bool operator()(const TEntry& a, const TEntry& b) const { return a.first > b.first; }
+	};
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::priority_queue<TEntry, std::vector<TEntry>, CLaterDeadline> entries;
+	bool stop = false;
+	std::thread thread;
+
+	void TimerLoop();
+};
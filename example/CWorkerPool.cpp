@@ -0,0 +1,336 @@
+#include "CWorkerPool.h"
+
+#include <algorithm>
+
+namespace
+{
+	// identifies the pool and worker index of the calling thread
+	thread_local const CWorkerPool* tlsWorkerPool = nullptr;
+	thread_local size_t tlsWorkerIdx = 0;
+}
+
+CWorkerPool::CWorkerPool(const size_t num_workers, const size_t num_reserved_workers, const CCpuTopology* topology)
+{
+	const size_t numWorkers = std::max<size_t>(num_workers, 1);
+	numReservedWorkers = std::min(num_reserved_workers, numWorkers - 1);
+	workerNodes.assign(numWorkers, 0);
+	if (topology && topology->GetNumCpus() > 0)
+	{
+		numNodes = topology->GetNumNodes();
+		for (auto&& [node, cpu] : topology->AssignWorkers(numWorkers))
+		{
+			workerNodes.at(workerCpus.size()) = node;
+			workerCpus.push_back(cpu);
+		}
+	}
+	workerQueues.reserve(numWorkers);
+	for (size_t idx = 0; idx < numWorkers; ++idx)
+		workerQueues.push_back(std::make_unique<CWorkerQueue>());
+	// the last counters are shared by the threads which are not workers
+	affinityCounters = std::make_unique<CAffinityCounters[]>(numWorkers + 1);
+	lastWriters = std::make_unique<std::atomic<size_t>[]>(NUM_LAST_WRITER_SLOTS);
+	for (size_t slot = 0; slot < NUM_LAST_WRITER_SLOTS; ++slot)
+		lastWriters[slot].store(NO_WORKER, std::memory_order_relaxed);
+	workers.reserve(numWorkers);
+	for (size_t idx = 0; idx < numWorkers; ++idx)
+		workers.emplace_back(&CWorkerPool::WorkerLoop, this, idx);
+}
+
+CWorkerPool::~CWorkerPool()
+{
+	{
+		std::scoped_lock lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+	reservedCondition.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+	// a thread outside of the pool (e.g. a timer resuming a task) may still be waking up the workers of its job
+	while (numExternalPushes.load() > 0)
+		std::this_thread::yield();
+}
+
+void CWorkerPool::Enqueue(TJob&& job, const ETaskLane lane)
+{
+	const size_t workerIdx = GetCurrentWorker();
+	// only normal jobs stay local, the other lanes have to be visible to all workers
+	CWorkerQueue& queue = lane == ETaskLane::NORMAL && workerIdx != NO_WORKER
+		                      ? *workerQueues.at(workerIdx)
+		                      : sharedQueues.at(static_cast<size_t>(lane));
+	Push(queue, std::move(job), lane, false);
+}
+
+void CWorkerPool::EnqueueWithAffinity(TJob&& job, const std::vector<Meta::CResourceAccessInfo>& resources,
+                                      const ETaskLane lane, const size_t node)
+{
+	const size_t preferredWorker = lane == ETaskLane::NORMAL ? GetPreferredWorker(resources, node) : NO_WORKER;
+	// the statistics and the last writers are updated before the job runs,
+	// the job may destroy the resources as its last step
+	TJob placedJob = [this, preferredWorker, &resources, job = std::move(job)]()
+	{
+		const size_t workerIdx = GetCurrentWorker();
+		CAffinityCounters& counters = affinityCounters[workerIdx == NO_WORKER ? workers.size() : workerIdx];
+		if (preferredWorker == NO_WORKER)
+			counters.numUnplaced.fetch_add(1, std::memory_order_relaxed);
+		else if (preferredWorker == workerIdx)
+			counters.numHits.fetch_add(1, std::memory_order_relaxed);
+		else
+			counters.numMisses.fetch_add(1, std::memory_order_relaxed);
+
+		for (const Meta::CResourceAccessInfo& resource : resources)
+			if (resource.accessMode == Meta::EResourceAccessMode::WRITE)
+				lastWriters[Meta::GetResourceSlot(resource.hashCode, NUM_LAST_WRITER_SLOTS)].store(
+					workerIdx, std::memory_order_relaxed);
+		job();
+	};
+
+	if (preferredWorker == NO_WORKER)
+		EnqueueOnNode(std::move(placedJob), node, lane);
+	else
+		// the preferred worker may sleep, so wake up all instead of a random one
+		Push(*workerQueues.at(preferredWorker), std::move(placedJob), lane, true);
+}
+
+void CWorkerPool::EnqueueOnNode(TJob&& job, const size_t node, const ETaskLane lane)
+{
+	const size_t nodeWorker = lane == ETaskLane::NORMAL ? GetNodeWorker(node) : NO_WORKER;
+	if (nodeWorker == NO_WORKER)
+		Enqueue(std::move(job), lane);
+	else
+		// wake up all, so the worker of the node is among the woken up ones
+		Push(*workerQueues.at(nodeWorker), std::move(job), lane, nodeWorker != GetCurrentWorker());
+}
+
+CWorkerPool::CAffinityStats CWorkerPool::GetAffinityStats() const
+{
+	CAffinityStats affinityStats;
+	for (size_t idx = 0; idx <= workers.size(); ++idx)
+	{
+		affinityStats.numHits += affinityCounters[idx].numHits.load(std::memory_order_relaxed);
+		affinityStats.numMisses += affinityCounters[idx].numMisses.load(std::memory_order_relaxed);
+		affinityStats.numUnplaced += affinityCounters[idx].numUnplaced.load(std::memory_order_relaxed);
+	}
+	return affinityStats;
+}
+
+void CWorkerPool::ResetAffinityStats()
+{
+	for (size_t idx = 0; idx <= workers.size(); ++idx)
+	{
+		affinityCounters[idx].numHits.store(0, std::memory_order_relaxed);
+		affinityCounters[idx].numMisses.store(0, std::memory_order_relaxed);
+		affinityCounters[idx].numUnplaced.store(0, std::memory_order_relaxed);
+	}
+}
+
+CWorkerPool::CStealStats CWorkerPool::GetStealStats() const
+{
+	return {numLocalSteals.load(), numRemoteSteals.load()};
+}
+
+void CWorkerPool::ResetStealStats()
+{
+	numLocalSteals = 0;
+	numRemoteSteals = 0;
+}
+
+void CWorkerPool::Push(CWorkerQueue& queue, TJob&& job, const ETaskLane lane, const bool wake_all)
+{
+	// the job may run and the pool may be destroyed before a thread outside of the pool returns from here
+	const bool externalPush = GetCurrentWorker() == NO_WORKER;
+	if (externalPush)
+		numExternalPushes.fetch_add(1);
+
+	// count before pushing, so the counter never drops below the number of queued jobs
+	numPendingJobs.fetch_add(1);
+	if (lane == ETaskLane::HIGH)
+		numPendingHighJobs.fetch_add(1);
+	{
+		std::scoped_lock lock(queue.mutex);
+		queue.jobs.push_back(std::move(job));
+	}
+
+	// a worker counts itself before checking for jobs, so it either finds the job or is counted here,
+	// the pool mutex is only taken if a worker sleeps
+	const bool wakeWorker = numSleepingWorkers.load() > 0;
+	const bool wakeReservedWorker = lane == ETaskLane::HIGH && numSleepingReservedWorkers.load() > 0;
+	if (wakeWorker || wakeReservedWorker)
+	{
+		{
+			// a worker between checking for jobs and waiting holds the lock, so it cannot miss the notification
+			std::scoped_lock lock(mutex);
+		}
+		if (wake_all)
+			condition.notify_all();
+		else if (wakeWorker)
+			condition.notify_one();
+		if (wakeReservedWorker)
+			reservedCondition.notify_one();
+	}
+	NotifyHelpers();
+
+	if (externalPush)
+		numExternalPushes.fetch_sub(1);
+}
+
+size_t CWorkerPool::GetPreferredWorker(const std::vector<Meta::CResourceAccessInfo>& resources,
+                                       const size_t node) const
+{
+	std::vector<size_t> votes(workers.size(), 0);
+	for (const Meta::CResourceAccessInfo& resource : resources)
+		if (const size_t lastWriter = lastWriters[Meta::GetResourceSlot(resource.hashCode, NUM_LAST_WRITER_SLOTS)].load(
+				std::memory_order_relaxed);
+			lastWriter != NO_WORKER)
+			++votes.at(lastWriter);
+
+	// reserved workers never execute normal jobs
+	size_t preferredWorker = NO_WORKER;
+	for (size_t workerIdx = numReservedWorkers; workerIdx < votes.size(); ++workerIdx)
+	{
+		if (node < numNodes && workerNodes.at(workerIdx) != node)
+			continue;
+		if (votes.at(workerIdx) > 0 && (preferredWorker == NO_WORKER || votes.at(workerIdx) > votes.at(preferredWorker)))
+			preferredWorker = workerIdx;
+	}
+	return preferredWorker;
+}
+
+size_t CWorkerPool::GetNodeWorker(const size_t node)
+{
+	if (node >= numNodes)
+		return NO_WORKER;
+	if (const size_t workerIdx = GetCurrentWorker();
+		workerIdx != NO_WORKER && !IsReservedWorker(workerIdx) && workerNodes.at(workerIdx) == node)
+		return workerIdx;
+
+	std::vector<size_t> nodeWorkers;
+	for (size_t workerIdx = numReservedWorkers; workerIdx < workerNodes.size(); ++workerIdx)
+		if (workerNodes.at(workerIdx) == node)
+			nodeWorkers.push_back(workerIdx);
+	if (nodeWorkers.empty())
+		return NO_WORKER;
+	return nodeWorkers.at(nextNodeWorker.fetch_add(1, std::memory_order_relaxed) % nodeWorkers.size());
+}
+
+bool CWorkerPool::RunPendingJob()
+{
+	TJob job;
+	// a helping reserved worker is busy anyway, so it may execute jobs of all lanes
+	if (!TryTakeJob(GetCurrentWorker(), false, job))
+		return false;
+	job();
+	NotifyHelpers();
+	return true;
+}
+
+void CWorkerPool::WorkerLoop(const size_t worker_idx)
+{
+	tlsWorkerPool = this;
+	tlsWorkerIdx = worker_idx;
+	if (worker_idx < workerCpus.size() && CCpuTopology::PinCurrentThread(workerCpus.at(worker_idx)))
+		numPinnedWorkers.fetch_add(1);
+	const bool reserved = IsReservedWorker(worker_idx);
+	const std::atomic<size_t>& numExecutableJobs = reserved ? numPendingHighJobs : numPendingJobs;
+
+	while (true)
+	{
+		TJob job;
+		if (TryTakeJob(worker_idx, reserved, job))
+		{
+			job();
+			// the job may have met the condition of a helper
+			NotifyHelpers();
+			continue;
+		}
+
+		std::unique_lock lock(mutex);
+		std::atomic<size_t>& numSleeping = reserved ? numSleepingReservedWorkers : numSleepingWorkers;
+		numSleeping.fetch_add(1);
+		(reserved ? reservedCondition : condition).wait(lock, [&]
+		{
+			return stopping || numExecutableJobs.load() > 0;
+		});
+		numSleeping.fetch_sub(1);
+		// finish all queued jobs before stopping
+		if (stopping && numExecutableJobs.load() == 0)
+			return;
+	}
+}
+
+size_t CWorkerPool::GetCurrentWorker() const
+{
+	return tlsWorkerPool == this ? tlsWorkerIdx : NO_WORKER;
+}
+
+bool CWorkerPool::TryTakeJob(const size_t worker_idx, const bool high_lane_only, TJob& job)
+{
+	// latency-critical jobs first
+	if (TryPopFront(sharedQueues.at(static_cast<size_t>(ETaskLane::HIGH)), job))
+	{
+		numPendingHighJobs.fetch_sub(1);
+		numPendingJobs.fetch_sub(1);
+		return true;
+	}
+	if (high_lane_only)
+		return false;
+
+	// own jobs next, newest first since their data is still in the cache
+	bool found = worker_idx != NO_WORKER && TryPopBack(*workerQueues.at(worker_idx), job);
+	found = found || TryPopFront(sharedQueues.at(static_cast<size_t>(ETaskLane::NORMAL)), job);
+	found = found || TrySteal(worker_idx, job);
+	// background jobs only if there is nothing else to do
+	found = found || TryPopFront(sharedQueues.at(static_cast<size_t>(ETaskLane::BACKGROUND)), job);
+
+	if (found)
+		numPendingJobs.fetch_sub(1);
+	return found;
+}
+
+bool CWorkerPool::TrySteal(const size_t worker_idx, TJob& job)
+{
+	// threads outside of the pool belong to no node and steal from everyone
+	const size_t numWorkers = workerQueues.size();
+	const size_t firstVictim = worker_idx == NO_WORKER ? 0 : worker_idx + 1;
+	const size_t ownNode = worker_idx == NO_WORKER ? CCpuTopology::NO_NODE : workerNodes.at(worker_idx);
+	const bool singleNode = numNodes == 1 || ownNode == CCpuTopology::NO_NODE;
+
+	// the own node first, then the others, starting with the next worker
+	for (const bool sameNode : {true, false})
+	{
+		if (singleNode && !sameNode)
+			break;
+		for (size_t offset = 0; offset < numWorkers; ++offset)
+		{
+			const size_t victim = (firstVictim + offset) % numWorkers;
+			if (victim == worker_idx || (!singleNode && (workerNodes.at(victim) == ownNode) != sameNode))
+				continue;
+			if (!TryPopFront(*workerQueues.at(victim), job))
+				continue;
+			if (worker_idx != NO_WORKER)
+				(sameNode ? numLocalSteals : numRemoteSteals).fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool CWorkerPool::TryPopBack(CWorkerQueue& queue, TJob& job)
+{
+	std::scoped_lock lock(queue.mutex);
+	if (queue.jobs.empty())
+		return false;
+	job = std::move(queue.jobs.back());
+	queue.jobs.pop_back();
+	return true;
+}
+
+bool CWorkerPool::TryPopFront(CWorkerQueue& queue, TJob& job)
+{
+	std::scoped_lock lock(queue.mutex);
+	if (queue.jobs.empty())
+		return false;
+	job = std::move(queue.jobs.front());
+	queue.jobs.pop_front();
+	return true;
+}
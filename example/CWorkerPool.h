@@ -0,0 +1,176 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <MetaResourceInfo.hpp>
+
+#include "CCpuTopology.h"
+#include "ITaskExecutor.h"
+
+/**
+ * \brief Fixed number of worker threads with one job queue per worker.
+ *        Jobs enqueued from a worker go to its own queue, which it works on newest first,
+ *        jobs from other threads go to a shared queue.
+ *        Idle workers steal the oldest jobs from the other queues.
+ *        Jobs of the high and background lanes always go to the shared queue of their lane,
+ *        a number of workers can be reserved for the high lane.
+ *        Jobs accessing resources can be placed on the worker that last wrote them, whose cache is still warm.
+ *        With a topology, the workers are pinned to its CPUs and grouped by memory node,
+ *        idle workers steal from workers of their own node first.
+ */
+class CWorkerPool final : public ITaskExecutor
+{
+public:
+	struct CAffinityStats
+	{
+		// placed jobs executed by the worker they were placed on
+		size_t numHits = 0;
+		// placed jobs executed by another thread, e.g. after stealing
+		size_t numMisses = 0;
+		// jobs without a known last writer of their resources
+		size_t numUnplaced = 0;
+	};
+
+	struct CStealStats
+	{
+		// jobs stolen from a worker of the same node
+		size_t numLocalSteals = 0;
+		// jobs stolen from a worker of another node, their data is probably in remote memory
+		size_t numRemoteSteals = 0;
+	};
+
+	/**
+	 * \param num_workers Number of worker threads, at least one
+	 * \param num_reserved_workers Number of workers only executing jobs of the high lane, at least one worker stays unreserved
+	 * \param topology Pins the workers to the CPUs of the topology node by node, nullptr leaves them to the OS
+	 *        and puts all of them into one node
+	 */
+	explicit CWorkerPool(size_t num_workers = std::thread::hardware_concurrency(), size_t num_reserved_workers = 0,
+	                     const CCpuTopology* topology = nullptr);
+	// executes all remaining jobs and joins the workers
+	~CWorkerPool() override;
+
+	CWorkerPool(const CWorkerPool&) = delete;
+	CWorkerPool& operator=(const CWorkerPool&) = delete;
+
+	void Enqueue(TJob&& job, ETaskLane lane = ETaskLane::NORMAL) override;
+
+	/**
+	 * \brief Enqueues the job into the local queue of the worker that last wrote most of its resources,
+	 *        other workers only get it by stealing. Jobs without a known writer are enqueued as usual.
+	 *        The thread executing the job becomes the last writer of its write resources.
+	 * \param job The job
+	 * \param resources Resources accessed by the job, have to stay valid until the job is started
+	 * \param lane Only jobs of the normal lane are placed, the other lanes always use the shared queues
+	 * \param node Only workers of this node are preferred, if none of them is a last writer the job goes to the node
+	 */
+	void EnqueueWithAffinity(TJob&& job, const std::vector<Meta::CResourceAccessInfo>& resources,
+	                         ETaskLane lane = ETaskLane::NORMAL, size_t node = CCpuTopology::NO_NODE) override;
+
+	/**
+	 * \brief Enqueues the job into the local queue of a worker of the node, e.g. the node holding the data of the job.
+	 *        Workers of other nodes only get it by stealing.
+	 * \param job The job
+	 * \param node Index of the node in the topology of the pool, jobs for unknown nodes are enqueued as usual
+	 * \param lane Only jobs of the normal lane are placed, the other lanes always use the shared queues
+	 */
+	void EnqueueOnNode(TJob&& job, size_t node, ETaskLane lane = ETaskLane::NORMAL) override;
+
+	CAffinityStats GetAffinityStats() const;
+	void ResetAffinityStats();
+
+	CStealStats GetStealStats() const;
+	void ResetStealStats();
+
+	bool RunPendingJob() override;
+
+	size_t GetNumWorkers() const override { return workers.size(); }
+	size_t GetNumReservedWorkers() const { return numReservedWorkers; }
+	// one node without a topology
+	size_t GetNumNodes() const { return numNodes; }
+	size_t GetWorkerNode(const size_t worker_idx) const { return workerNodes.at(worker_idx); }
+	// workers which were pinned to their CPU successfully
+	size_t GetNumPinnedWorkers() const { return numPinnedWorkers.load(); }
+	// true if called from one of the workers of this pool
+	bool IsWorkerThread() const override { return GetCurrentWorker() != NO_WORKER; }
+	// index of the calling thread in this pool or NO_WORKER
+	size_t GetCurrentWorker() const override;
+	// jobs waiting in any queue
+	size_t GetNumPendingJobs() const override { return numPendingJobs.load(std::memory_order_relaxed); }
+
+private:
+	static constexpr size_t NUM_LANES = 3;
+
+	struct CWorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<TJob> jobs;
+	};
+
+	// protects sleeping and waking up
+	std::mutex mutex;
+	std::condition_variable condition;
+	// reserved workers wait separately, so they never take the notification for a job they cannot execute
+	std::condition_variable reservedCondition;
+	bool stopping = false;
+	// workers waiting for the conditions, a push only takes the mutex to wake them if there are any
+	std::atomic<size_t> numSleepingWorkers = 0;
+	std::atomic<size_t> numSleepingReservedWorkers = 0;
+	// pushes of threads outside of the pool in progress, the destructor waits for them
+	std::atomic<size_t> numExternalPushes = 0;
+	std::atomic<size_t> numPendingJobs = 0;
+	std::atomic<size_t> numPendingHighJobs = 0;
+	// the first workers are reserved for the high lane
+	size_t numReservedWorkers = 0;
+	size_t numNodes = 1;
+	// node and CPU per worker, no CPUs without a topology
+	std::vector<size_t> workerNodes;
+	std::vector<size_t> workerCpus;
+	std::atomic<size_t> numPinnedWorkers = 0;
+	// spreads jobs placed on a node over its workers
+	std::atomic<size_t> nextNodeWorker = 0;
+	std::array<CWorkerQueue, NUM_LANES> sharedQueues;
+	std::vector<std::unique_ptr<CWorkerQueue>> workerQueues;
+	std::vector<std::thread> workers;
+
+	// counted by the thread executing the placed job, so they never share a cache line with another worker
+	struct alignas(64) CAffinityCounters
+	{
+		std::atomic<size_t> numHits = 0;
+		std::atomic<size_t> numMisses = 0;
+		std::atomic<size_t> numUnplaced = 0;
+	};
+
+	// resources sharing a slot share their last writer, which only costs a hit now and then
+	static constexpr size_t NUM_LAST_WRITER_SLOTS = 4096;
+
+	// one per worker and one for the threads which are not workers
+	std::unique_ptr<CAffinityCounters[]> affinityCounters;
+	// last writing worker per slot of the resource hash codes, or NO_WORKER
+	std::unique_ptr<std::atomic<size_t>[]> lastWriters;
+	std::atomic<size_t> numLocalSteals = 0;
+	std::atomic<size_t> numRemoteSteals = 0;
+
+	void WorkerLoop(size_t worker_idx);
+	// pushes the job and wakes up a worker
+	void Push(CWorkerQueue& queue, TJob&& job, ETaskLane lane, bool wake_all);
+	// worker which last wrote most of the resources or NO_WORKER
+	size_t GetPreferredWorker(const std::vector<Meta::CResourceAccessInfo>& resources, size_t node) const;
+	// unreserved worker of the node, the calling worker if it belongs to the node, or NO_WORKER
+	size_t GetNodeWorker(size_t node);
+	bool IsReservedWorker(size_t worker_idx) const { return worker_idx < numReservedWorkers; }
+	// takes the job of the highest lane, reserved workers only take jobs of the high lane
+	bool TryTakeJob(size_t worker_idx, bool high_lane_only, TJob& job);
+	// steals the oldest job of another worker, workers of the own node first
+	bool TrySteal(size_t worker_idx, TJob& job);
+	static bool TryPopBack(CWorkerQueue& queue, TJob& job);
+	static bool TryPopFront(CWorkerQueue& queue, TJob& job);
+};
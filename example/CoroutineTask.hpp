@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <functional>
+
+#include "CTaskCoroutine.h"
+#include "ITaskExecutor.h"
+#include "Task.hpp"
+
+/**
+ * \brief Task whose body is a coroutine, which can wait for I/O or a timer (see CTaskEvent and CTaskTimer).
+ *        While the body is suspended its worker executes other tasks, but the task keeps its resources:
+ *        its dependents are only released when the body returned.
+ *        After a suspension the body continues on any worker of the pool.
+ *        Executed synchronously (DoTask), the calling thread helps the pool until the body returned.
+ * \tparam MethodAnnotations List of method resources, held for the whole lifetime of the coroutine
+ */
+template <Meta::method_resources... MethodAnnotations>
+class CCoroutineTask final : public ITask
+{
+public:
+	using TBody = std::function<CTaskCoroutine()>;
+	using TResources = std::tuple<MethodAnnotations...>;
+
+	static constexpr auto GetFilteredResources() { return TResourceTask::GetFilteredResources(); }
+
+	/**
+	 * \param executor Executor the body continues on after a suspension, usually the one of the scheduler
+	 * \param body Coroutine called once for every execution of the task
+	 */
+	CCoroutineTask(ITaskExecutor& executor, TBody&& body)
+		: ITask([this] { ExecuteSynchronously(); })
+		, executor(executor)
+		, body(std::move(body))
+	{
+		if constexpr (TResourceTask::DECLARED_COST.has_value())
+			SetEstimatedCost(*TResourceTask::DECLARED_COST);
+	}
+
+	~CCoroutineTask() override = default;
+
+	bool IsAsync() const override { return true; }
+
+	void StartAsync(TCompletion&& on_finished) override
+	{
+		// the coroutine of the previous execution finished, it is only destroyed here
+		coroutine = body();
+		coroutine.Start(executor, GetLane(), std::move(on_finished));
+	}
+
+	size_t GetNumResources() override { return TResourceTask::NUM_RESOURCES; }
+
+	std::any GetMetaResource(size_t idx) override
+	{
+		return TResourceTask::GetResourceElementAt(idx, std::make_index_sequence<TResourceTask::NUM_RESOURCES>{});
+	}
+
+	std::any GetMetaResources() override { return TResourceTask::RESOURCES; }
+
+	void AddTaskToBuilder(entt::flow& builder) override
+	{
+		const auto taskId = reinterpret_cast<entt::id_type>(
+			static_cast<void*>(this) // <- use pointer as uid
+		);
+		builder.bind(taskId);
+		TResourceTask::RegisterResources(builder);
+	}
+
+	const std::vector<Meta::CResourceAccessInfo>& GetResourceAccessInfos() const override
+	{
+		return TResourceTask::GetFilteredResourceInfos();
+	}
+
+private:
+	using TResourceTask = CTask<MethodAnnotations...>;
+
+	ITaskExecutor& executor;
+	const TBody body;
+	CTaskCoroutine coroutine;
+
+	void ExecuteSynchronously()
+	{
+		std::atomic<bool> finished = false;
+		StartAsync([&finished, pExecutor = &executor]
+		{
+			// the task may be gone as soon as finished is set
+			ITaskExecutor& taskExecutor = *pExecutor;
+			finished.store(true);
+			taskExecutor.NotifyHelpers();
+		});
+		// help executing the continuations instead of blocking
+		executor.HelpUntil([&finished] { return finished.load(); });
+	}
+};
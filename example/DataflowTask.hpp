@@ -0,0 +1,204 @@
+#pragma once
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include <MetaResourceInfo.hpp>
+
+#include "CTaskResultArena.h"
+#include "Task.hpp"
+
+/**
+ * \brief Typed result of a task, handed to the tasks depending on it.
+ *        The value lives in the result arena of the scheduler, the output only refers to it.
+ *        To the schedulers the output is a resource of its own: the producer writes it,
+ *        so it is ordered before the consumers queued after it.
+ * \tparam T Type of the result
+ */
+template <typename T>
+class CTaskOutput
+{
+public:
+	using TValue = T;
+
+	CTaskOutput() = default;
+	~CTaskOutput() = default;
+
+	CTaskOutput(const CTaskOutput&) = delete;
+	CTaskOutput& operator=(const CTaskOutput&) = delete;
+
+	// true after the producer ran, until the arena is reset
+	bool HasValue() const { return pValue && pArena->GetGeneration() == generation; }
+
+	T& Get() const
+	{
+		assert(HasValue() && "The producer of the output did not run in this batch.");
+		return *pValue;
+	}
+
+	// moves the value into the arena
+	void Set(CTaskResultArena& result_arena, T&& value)
+	{
+		pArena = &result_arena;
+		generation = result_arena.GetGeneration();
+		pValue = result_arena.Store(std::move(value));
+	}
+
+	/**
+	 * \brief Describes an access to the output like an access to a member, so it gets an edge in the graph.
+	 * \param access_mode WRITE for the producer and for consumers taking the value, READ for consumers referencing it
+	 */
+	Meta::CResourceAccessInfo GetAccessInfo(const Meta::EResourceAccessMode access_mode) const
+	{
+		Meta::CResourceAccessInfo info{};
+		// outputs are unique by their address, like tasks in the graph
+		info.hashCode = reinterpret_cast<size_t>(this);
+		info.accessMode = access_mode;
+		info.classHashCode = typeid(CTaskOutput).hash_code();
+		info.className = Meta::GetTypeName<T>();
+		info.memberName = "output";
+		return info;
+	}
+
+private:
+	CTaskResultArena* pArena = nullptr;
+	size_t generation = 0;
+	T* pValue = nullptr;
+};
+
+/**
+ * \brief Checks if we have a valid input of a dataflow task:
+ *        `const T&` references the output, `T&&` takes it over and leaves it moved from.
+ * \tparam T The type to check
+ */
+template <typename T>
+concept task_input = std::is_rvalue_reference_v<T>
+	|| (std::is_lvalue_reference_v<T> && std::is_const_v<std::remove_reference_t<T>>);
+
+template <typename Signature, Meta::method_resources... MethodAnnotations>
+class CDataflowTask;
+
+/**
+ * \brief Task passing its result directly to the tasks depending on it, instead of through a shared member.
+ *        The result is moved into the result arena and the consumers get it by reference or by move,
+ *        so large buffers are never copied.
+ *        Consumers have to be queued after their producers, like for any other resource.
+ *        With the streaming scheduler, the owner of the arena resets it once the tasks are done.
+ * \tparam Result Type of the result, void if the task produces nothing
+ * \tparam Inputs Outputs of other tasks as `const T&` or `T&&`
+ * \tparam MethodAnnotations List of method resources
+ */
+template <typename Result, typename... Inputs, Meta::method_resources... MethodAnnotations>
+class CDataflowTask<Result(Inputs...), MethodAnnotations...> final : public ITask
+{
+	static_assert((task_input<Inputs> && ...), "Inputs have to be taken as const T& or T&&.");
+
+public:
+	using TResult = Result;
+	using TBody = std::function<Result(Inputs...)>;
+	template <typename Input>
+	using TInput = std::shared_ptr<CTaskOutput<std::remove_cvref_t<Input>>>;
+
+	static constexpr auto GetFilteredResources() { return TResourceTask::GetFilteredResources(); }
+
+	/**
+	 * \param result_arena Arena the result is stored in, usually the one of the scheduler
+	 * \param body Called with the values of the inputs, returns the result
+	 * \param inputs Outputs of the producers, in the order of Inputs
+	 */
+	CDataflowTask(CTaskResultArena& result_arena, TBody&& body, TInput<Inputs>... inputs)
+		: ITask([this] { Execute(); })
+		, resultArena(result_arena)
+		, body(std::move(body))
+		, inputs(std::move(inputs)...)
+		, resources(TResourceTask::GetFilteredResourceInfos())
+	{
+		if constexpr (TResourceTask::DECLARED_COST.has_value())
+			SetEstimatedCost(*TResourceTask::DECLARED_COST);
+
+		std::apply([this](const auto&... input)
+		{
+			(resources.push_back(input->GetAccessInfo(std::is_rvalue_reference_v<Inputs>
+				                                          ? Meta::EResourceAccessMode::WRITE
+				                                          : Meta::EResourceAccessMode::READ)), ...);
+		}, this->inputs);
+		if constexpr (!std::is_void_v<Result>)
+			resources.push_back(pOutput->GetAccessInfo(Meta::EResourceAccessMode::WRITE));
+	}
+
+	~CDataflowTask() override = default;
+
+	size_t GetNumResources() override { return TResourceTask::NUM_RESOURCES; }
+
+	std::any GetMetaResource(size_t idx) override
+	{
+		return TResourceTask::GetResourceElementAt(idx, std::make_index_sequence<TResourceTask::NUM_RESOURCES>{});
+	}
+
+	std::any GetMetaResources() override { return TResourceTask::RESOURCES; }
+
+	void AddTaskToBuilder(entt::flow& builder) override
+	{
+		const auto taskId = reinterpret_cast<entt::id_type>(
+			static_cast<void*>(this) // <- use pointer as uid
+		);
+		builder.bind(taskId);
+		// the filtered resources followed by the inputs and the output
+		for (const Meta::CResourceAccessInfo& resource : resources)
+		{
+			if (resource.accessMode == Meta::EResourceAccessMode::WRITE)
+				builder.rw(resource.hashCode);
+			else
+				builder.ro(resource.hashCode);
+		}
+	}
+
+	const std::vector<Meta::CResourceAccessInfo>& GetResourceAccessInfos() const override { return resources; }
+
+	// output to pass to the consumers, has a value after the task ran
+	const TInput<Result>& GetOutput() const requires (!std::is_void_v<Result>) { return pOutput; }
+
+private:
+	using TResourceTask = CTask<MethodAnnotations...>;
+	using TOutput = std::conditional_t<std::is_void_v<Result>, std::nullptr_t, std::shared_ptr<CTaskOutput<Result>>>;
+
+	CTaskResultArena& resultArena;
+	const TBody body;
+	const std::tuple<TInput<Inputs>...> inputs;
+	TOutput pOutput = MakeOutput();
+	std::vector<Meta::CResourceAccessInfo> resources;
+
+	static TOutput MakeOutput()
+	{
+		if constexpr (std::is_void_v<Result>)
+			return nullptr;
+		else
+			return std::make_shared<CTaskOutput<Result>>();
+	}
+
+	template <typename Input>
+	static Input TakeInput(const TInput<Input>& input)
+	{
+		if constexpr (std::is_rvalue_reference_v<Input>)
+			return std::move(input->Get());
+		else
+			return input->Get();
+	}
+
+	void Execute() const
+	{
+		auto callBody = [this]<size_t... Idx>(std::index_sequence<Idx...>) -> Result
+		{
+			return body(TakeInput<Inputs>(std::get<Idx>(inputs))...);
+		};
+		if constexpr (std::is_void_v<Result>)
+			callBody(std::index_sequence_for<Inputs...>{});
+		else
+			pOutput->Set(resultArena, callBody(std::index_sequence_for<Inputs...>{}));
+	}
+};
@@ -4,7 +4,7 @@
 class IFooBar
 {
 public:
-	virtual ~IFooBar();
+	virtual ~IFooBar() = default;
 
 	virtual int AbstractMethod() = 0;
 	virtual int VirtualMethod()
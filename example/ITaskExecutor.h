@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <MetaResourceInfo.hpp>
+
+#include "CCpuTopology.h"
+
+/**
+ * \brief Lanes separate latency-critical from background work.
+ *        Higher lanes are always served first, background jobs only run on otherwise idle workers.
+ */
+enum class ETaskLane
+{
+	HIGH,
+	NORMAL,
+	BACKGROUND
+};
+
+/**
+ * \brief Backend the schedulers dispatch their ready tasks into.
+ *        CWorkerPool executes the jobs on its worker threads,
+ *        CInlineExecutor only on the threads waiting for them, in a deterministic order.
+ *        Placement hints are optional, executors without workers or nodes enqueue such jobs as usual.
+ */
+class ITaskExecutor
+{
+public:
+	using TJob = std::function<void()>;
+
+	static constexpr size_t NO_WORKER = static_cast<size_t>(-1);
+
+	virtual ~ITaskExecutor() = default;
+
+	// safe to call from any thread
+	virtual void Enqueue(TJob&& job, ETaskLane lane = ETaskLane::NORMAL) = 0;
+
+	/**
+	 * \brief Enqueues the job close to the last writer of its resources, see CWorkerPool::EnqueueWithAffinity.
+	 * \param job The job
+	 * \param resources Resources accessed by the job, have to stay valid until the job is started
+	 * \param lane Lane of the job
+	 * \param node Preferred memory node of the job
+	 */
+	virtual void EnqueueWithAffinity(TJob&& job, [[maybe_unused]] const std::vector<Meta::CResourceAccessInfo>& resources,
+	                                 const ETaskLane lane = ETaskLane::NORMAL,
+	                                 [[maybe_unused]] const size_t node = CCpuTopology::NO_NODE)
+	{
+		Enqueue(std::move(job), lane);
+	}
+
+	// enqueues the job on a worker of the memory node, see CWorkerPool::EnqueueOnNode
+	virtual void EnqueueOnNode(TJob&& job, [[maybe_unused]] const size_t node, const ETaskLane lane = ETaskLane::NORMAL)
+	{
+		Enqueue(std::move(job), lane);
+	}
+
+	/**
+	 * \brief Executes one pending job on the calling thread.
+	 * \return false if there was no job to execute
+	 */
+	virtual bool RunPendingJob() = 0;
+
+	// threads executing jobs at the same time
+	virtual size_t GetNumWorkers() const = 0;
+	// jobs waiting to be executed
+	virtual size_t GetNumPendingJobs() const = 0;
+	// true if blocking the calling thread could keep the jobs it waits for from being executed
+	virtual bool IsWorkerThread() const = 0;
+	// index of the calling worker below GetNumWorkers, NO_WORKER for other threads, e.g. ones helping in HelpUntil
+	virtual size_t GetCurrentWorker() const { return NO_WORKER; }
+
+	/**
+	 * \brief Executes pending jobs until the condition is met,
+	 *        so a thread waiting for its jobs helps instead of blocking.
+	 *        Without pending jobs it sleeps until a job is enqueued or NotifyHelpers is called.
+	 */
+	template <typename Condition>
+	void HelpUntil(Condition&& condition);
+
+	/**
+	 * \brief Wakes the threads sleeping in HelpUntil, so they check their conditions again.
+	 *        Executors call it for every enqueued and every finished job,
+	 *        anything else making a condition true (e.g. a timer resuming a task) has to call it afterwards.
+	 */
+	void NotifyHelpers();
+
+private:
+	std::mutex helpMutex;
+	std::condition_variable helpCondition;
+	// changed by every notification of a sleeping helper, a helper only sleeps while it is unchanged since it was read
+	std::atomic<std::uint64_t> helpEpoch = 0;
+	// helpers about to sleep, without any the notifications cost a single load
+	std::atomic<size_t> numSleepingHelpers = 0;
+
+	void WaitForNotification(std::uint64_t help_epoch);
+};
+
+template <typename Condition>
+void ITaskExecutor::HelpUntil(Condition&& condition)
+{
+	while (!condition())
+	{
+		if (RunPendingJob())
+			continue;
+		// counted before checking again, so a notification after the second check sees the helper,
+		// and the epoch is read before it, so a notification during the check keeps the helper awake
+		numSleepingHelpers.fetch_add(1);
+		const std::uint64_t epoch = helpEpoch.load();
+		if (!condition() && !RunPendingJob())
+			WaitForNotification(epoch);
+		numSleepingHelpers.fetch_sub(1);
+	}
+}
+
+inline void ITaskExecutor::NotifyHelpers()
+{
+	// a helper counts itself before checking its condition again, so it either sees the change or is counted here
+	if (numSleepingHelpers.load() == 0)
+		return;
+	helpEpoch.fetch_add(1);
+	{
+		// a helper between checking the epoch and waiting holds the lock, so it cannot miss the notification
+		std::scoped_lock lock(helpMutex);
+	}
+	helpCondition.notify_all();
+}
+
+inline void ITaskExecutor::WaitForNotification(const std::uint64_t help_epoch)
+{
+	std::unique_lock lock(helpMutex);
+	helpCondition.wait(lock, [&] { return helpEpoch.load() != help_epoch; });
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <functional>
+
+#include "ITaskExecutor.h"
+#include "Task.hpp"
+
+/**
+ * \brief Half-open range of indices [begin, end).
+ */
+template <std::integral Index>
+struct CIndexRange
+{
+	Index begin;
+	Index end;
+
+	Index GetSize() const { return end > begin ? end - begin : 0; }
+};
+
+/**
+ * \brief Checks if we have the structure of a CIndexRange.
+ * \tparam T The type to check
+ */
+template <typename T>
+concept index_range = requires(T range) { range.begin; range.end; range.GetSize(); };
+
+/**
+ * \brief Data-parallel task: one vertex for the scheduler, but its body is executed in chunks across the worker pool.
+ *        The range is split lazily in halves as long as the chunks are larger than the minimum grain size
+ *        and the pool has idle workers, idle workers steal the split off halves.
+ *        The task completes, and its children are released, only when all chunks are finished.
+ * \tparam Range CIndexRange the body is executed on
+ * \tparam MethodAnnotations List of method resources, shared by all chunks
+ */
+template <typename Range, Meta::method_resources... MethodAnnotations>
+class CParallelTask final : public ITask
+{
+	static_assert(index_range<Range>, "Range has to be a CIndexRange.");
+
+public:
+	using TRange = Range;
+	using TBody = std::function<void(TRange chunk)>;
+	using TResources = std::tuple<MethodAnnotations...>;
+
+	static constexpr auto GetFilteredResources() { return TResourceTask::GetFilteredResources(); }
+
+	/**
+	 * \param executor Pool or other executor executing the chunks, usually the one of the scheduler
+	 * \param range The whole range of indices
+	 * \param body Called for every chunk, chunks of the same task may run at the same time
+	 */
+	CParallelTask(ITaskExecutor& executor, TRange range, TBody&& body)
+		: ITask([this] { ExecuteChunks(); })
+		, executor(executor)
+		, range(range)
+		, body(std::move(body))
+	{
+		// the declared cost is the one of the whole range
+		if constexpr (TResourceTask::DECLARED_COST.has_value())
+			SetEstimatedCost(*TResourceTask::DECLARED_COST);
+	}
+
+	~CParallelTask() override = default;
+
+	size_t GetNumResources() override { return TResourceTask::NUM_RESOURCES; }
+
+	std::any GetMetaResource(size_t idx) override
+	{
+		return TResourceTask::GetResourceElementAt(idx, std::make_index_sequence<TResourceTask::NUM_RESOURCES>{});
+	}
+
+	std::any GetMetaResources() override { return TResourceTask::RESOURCES; }
+
+	void AddTaskToBuilder(entt::flow& builder) override
+	{
+		const auto taskId = reinterpret_cast<entt::id_type>(
+			static_cast<void*>(this) // <- use pointer as uid
+		);
+		builder.bind(taskId);
+		TResourceTask::RegisterResources(builder);
+	}
+
+	const std::vector<Meta::CResourceAccessInfo>& GetResourceAccessInfos() const override
+	{
+		return TResourceTask::GetFilteredResourceInfos();
+	}
+
+	// chunks are never split below this size, 0 picks a grain size based on the range and the number of workers
+	void SetMinGrainSize(const size_t min_grain_size) { minGrainSize = min_grain_size; }
+
+private:
+	using TResourceTask = CTask<MethodAnnotations...>;
+
+	ITaskExecutor& executor;
+	const TRange range;
+	const TBody body;
+	size_t minGrainSize = 0;
+
+	void ExecuteChunks() const
+	{
+		// at least some chunks per worker, so stealing can balance uneven chunks
+		constexpr size_t chunksPerWorker = 4;
+		const size_t grainSize = minGrainSize > 0
+			                         ? minGrainSize
+			                         : std::max<size_t>(range.GetSize() / (executor.GetNumWorkers() * chunksPerWorker), 1);
+
+		std::atomic<size_t> numPendingChunks = 1;
+		ExecuteChunk(range, grainSize, numPendingChunks);
+		// help executing the chunks instead of blocking
+		executor.HelpUntil([&numPendingChunks] { return numPendingChunks.load() == 0; });
+	}
+
+	void ExecuteChunk(TRange chunk, const size_t grain_size, std::atomic<size_t>& num_pending_chunks) const
+	{
+		// split as long as there are workers without work
+		while (static_cast<size_t>(chunk.GetSize()) > grain_size
+			&& executor.GetNumPendingJobs() < executor.GetNumWorkers())
+		{
+			TRange secondHalf = chunk;
+			secondHalf.begin = chunk.begin + (chunk.end - chunk.begin) / 2;
+			chunk.end = secondHalf.begin;
+
+			num_pending_chunks.fetch_add(1);
+			executor.Enqueue([this, secondHalf, grain_size, &num_pending_chunks]
+			{
+				ExecuteChunk(secondHalf, grain_size, num_pending_chunks);
+			}, GetLane());
+		}
+
+		body(chunk);
+		// the task may be gone as soon as the last chunk is counted
+		ITaskExecutor& taskExecutor = executor;
+		if (num_pending_chunks.fetch_sub(1) == 1)
+			taskExecutor.NotifyHelpers();
+	}
+};
@@ -1,9 +1,17 @@
 #pragma once
 #include <any>
+#include <chrono>
+#include <concepts>
 #include <functional>
+#include <optional>
 #include <tuple>
+#include <typeinfo>
+#include <vector>
 
 #include <Meta.hpp>
+#include <MetaResourceInfo.hpp>
+
+#include "ITaskExecutor.h"
 
 // take uint64_t, so we can use 64-bit pointers as unique id in the graph builder
 #ifndef ENTT_ID_TYPE
@@ -16,6 +24,8 @@ class ITask
 {
 public:
 	using TTaskFunction = std::function<void()>;
+	using TCompletion = std::function<void()>;
+	using TCost = std::chrono::nanoseconds;
 
 	ITask() = default;
 
@@ -30,11 +40,51 @@ public:
 	virtual std::any GetMetaResource(size_t idx) = 0;
 	virtual std::any GetMetaResources() = 0;
 	virtual void AddTaskToBuilder(entt::flow& builder) = 0;
+	// runtime description of the filtered resources
+	virtual const std::vector<Meta::CResourceAccessInfo>& GetResourceAccessInfos() const = 0;
 
 	void DoTask() const { function(); }
 
+	// true if the task may still run after StartAsync returned, see CCoroutineTask
+	virtual bool IsAsync() const { return false; }
+
+	/**
+	 * \brief Starts the task, on_finished is called once it is complete, possibly from another thread.
+	 *        The dependents of the task may only start after that.
+	 *        Other tasks are complete when this returns.
+	 */
+	virtual void StartAsync(TCompletion&& on_finished)
+	{
+		DoTask();
+		on_finished();
+	}
+
+	// declared execution time, takes precedence over the measured one
+	void SetEstimatedCost(const TCost cost) { estimatedCost = cost; }
+	// last measured execution time, set by the scheduler
+	void SetMeasuredCost(const TCost cost) { measuredCost = cost; }
+	// declared or measured execution time, empty if the task never ran and has no declared cost
+	std::optional<TCost> GetCost() const { return estimatedCost ? estimatedCost : measuredCost; }
+
+	// lane of the worker pool the task is executed in, dependencies between tasks hold across lanes
+	void SetLane(const ETaskLane task_lane) { lane = task_lane; }
+	ETaskLane GetLane() const { return lane; }
+
+	// a deferrable task may be handed back to the next frame if the frame runs out of time
+	void SetDeferrable(const bool is_deferrable) { deferrable = is_deferrable; }
+	bool IsDeferrable() const { return deferrable; }
+
+	// memory node whose workers should execute the task, see CWorkerPool::EnqueueOnNode
+	void SetNodeHint(const size_t node) { nodeHint = node; }
+	size_t GetNodeHint() const { return nodeHint; }
+
 private:
 	TTaskFunction function;
+	ETaskLane lane = ETaskLane::NORMAL;
+	bool deferrable = false;
+	size_t nodeHint = CCpuTopology::NO_NODE;
+	std::optional<TCost> estimatedCost;
+	std::optional<TCost> measuredCost;
 };
 
 template <Meta::method_resources... MethodAnnotations>
@@ -48,11 +98,26 @@ public:
 	// this tuple is then returned
 	static constexpr auto GetFilteredResources();
 
-	CTask() = default;
+	// sum of the costs declared by the method annotations, empty if none of them declares a cost
+	static constexpr std::optional<TCost> DECLARED_COST = []() -> std::optional<TCost>
+	{
+		if constexpr ((Meta::cost_annotated<MethodAnnotations> || ...))
+			return (TCost::zero() + ... + Meta::GetEstimatedCost<MethodAnnotations>());
+		else
+			return std::nullopt;
+	}();
+
+	CTask()
+	{
+		if constexpr (DECLARED_COST.has_value())
+			SetEstimatedCost(*DECLARED_COST);
+	}
 
 	explicit CTask(TTaskFunction&& task_function)
 		: ITask(std::move(task_function))
 	{
+		if constexpr (DECLARED_COST.has_value())
+			SetEstimatedCost(*DECLARED_COST);
 	}
 
 	~CTask() override = default;
@@ -70,8 +135,23 @@ public:
 	}
 
 	void AddTaskToBuilder(entt::flow& builder) override;
+	const std::vector<Meta::CResourceAccessInfo>& GetResourceAccessInfos() const override;
+
+	// registers the filtered resources for the task that is currently bound to the builder
+	static void RegisterResources(entt::flow& builder);
+	// runtime description of the filtered resources, same for every task of this type
+	static const std::vector<Meta::CResourceAccessInfo>& GetFilteredResourceInfos();
 
 private:
+	template <typename Base, typename FallbackTask, typename... Variants>
+	friend class CVirtualTask;
+	template <typename Range, Meta::method_resources... Annotations>
+	friend class CParallelTask;
+	template <typename Signature, Meta::method_resources... Annotations>
+	friend class CDataflowTask;
+	template <Meta::method_resources... Annotations>
+	friend class CCoroutineTask;
+
 	static constexpr auto RESOURCES = TResources{};
 	static constexpr auto NUM_RESOURCES = std::tuple_size_v<TResources>;
 
@@ -97,6 +177,22 @@ private:
 
 template <Meta::method_resources ... MethodAnnotations>
 void CTask<MethodAnnotations...>::AddTaskToBuilder(entt::flow& builder)
+{
+	const auto taskId = reinterpret_cast<entt::id_type>(
+		static_cast<void*>(this) // <- use pointer as uid
+	);
+	builder.bind(taskId);
+	RegisterResources(builder);
+}
+
+template <Meta::method_resources ... MethodAnnotations>
+const std::vector<Meta::CResourceAccessInfo>& CTask<MethodAnnotations...>::GetResourceAccessInfos() const
+{
+	return GetFilteredResourceInfos();
+}
+
+template <Meta::method_resources ... MethodAnnotations>
+void CTask<MethodAnnotations...>::RegisterResources(entt::flow& builder)
 {
 	constexpr auto resources = GetFilteredResources();
 	// lambda for std::apply
@@ -107,14 +203,17 @@ void CTask<MethodAnnotations...>::AddTaskToBuilder(entt::flow& builder)
 			  : builder.ro(tuple_args.GetHashCode()))
 			, ...);
 	};
-
-	const auto taskId = reinterpret_cast<entt::id_type>(
-		static_cast<void*>(this) // <- use pointer as uid
-	);
-	builder.bind(taskId);
 	std::apply(registerResources, resources);
 }
 
+template <Meta::method_resources ... MethodAnnotations>
+const std::vector<Meta::CResourceAccessInfo>& CTask<MethodAnnotations...>::GetFilteredResourceInfos()
+{
+	// same for every task of this type, so we only create it once
+	static const std::vector<Meta::CResourceAccessInfo> infos = Meta::GetResourceAccessInfos(GetFilteredResources());
+	return infos;
+}
+
 template <Meta::method_resources ... MethodAnnotations>
 template <std::size_t Idx>
 std::any CTask<MethodAnnotations...>::GetResourceElementAt(const size_t idx)
@@ -170,3 +269,120 @@ constexpr auto CTask<MethodAnnotations...>::FilterResources(std::tuple<Unfiltere
 	using TMethodResources = Meta::CMethodResources<UnfilteredResources...>;
 	return TMethodResources::GetFilteredResources();
 }
+
+/**
+ * \brief Links a concrete class with the task declaring the resources used for objects of this class.
+ * \tparam Class The dynamic type of the object
+ * \tparam Task CTask with the method annotations of the concrete class
+ */
+template <typename Class, typename Task>
+struct CResourceVariant
+{
+	using TClass = Class;
+	using TTask = Task;
+};
+
+/**
+ * \brief Task calling a virtual method through a base class.
+ *        Instead of the union of all derived resources, it selects the resources of the actual dynamic type
+ *        when it is created, so the scheduler only builds edges from the narrower set.
+ * \tparam Base The base class the method is called on
+ * \tparam FallbackTask CTask declaring the union of all resources, used if no variant matches
+ * \tparam Variants List of CResourceVariant for the derived classes
+ */
+template <typename Base, typename FallbackTask, typename... Variants>
+class CVirtualTask final : public ITask
+{
+	static_assert((std::derived_from<typename Variants::TClass, Base> && ...),
+	              "Every variant has to be a class derived from the base class.");
+	static_assert((Meta::resource_subset_v<typename Variants::TTask, FallbackTask> && ...),
+	              "The fallback task has to declare all resources of the variants, it is used for the compile time checks.");
+
+public:
+	// the dynamic type is unknown at compile time, so compile time checks have to use the union of all resources
+	static constexpr auto GetFilteredResources() { return FallbackTask::GetFilteredResources(); }
+
+	CVirtualTask(const Base& object, TTaskFunction&& task_function)
+		: ITask(std::move(task_function))
+		, variantIdx(SelectVariant(typeid(object), std::make_index_sequence<sizeof...(Variants)>{}))
+	{
+		VisitVariant([this]<typename Task>()
+		{
+			if constexpr (Task::DECLARED_COST.has_value())
+				SetEstimatedCost(*Task::DECLARED_COST);
+		});
+	}
+
+	~CVirtualTask() override = default;
+
+	size_t GetNumResources() override
+	{
+		return VisitVariant([]<typename Task>() { return Task::NUM_RESOURCES; });
+	}
+
+	std::any GetMetaResource(size_t idx) override
+	{
+		return VisitVariant([idx]<typename Task>()
+		{
+			return Task::GetResourceElementAt(idx, std::make_index_sequence<Task::NUM_RESOURCES>{});
+		});
+	}
+
+	std::any GetMetaResources() override
+	{
+		return VisitVariant([]<typename Task>() -> std::any { return Task::RESOURCES; });
+	}
+
+	void AddTaskToBuilder(entt::flow& builder) override
+	{
+		const auto taskId = reinterpret_cast<entt::id_type>(
+			static_cast<void*>(this) // <- use pointer as uid
+		);
+		builder.bind(taskId);
+		VisitVariant([&builder]<typename Task>() { Task::RegisterResources(builder); });
+	}
+
+	const std::vector<Meta::CResourceAccessInfo>& GetResourceAccessInfos() const override
+	{
+		return VisitVariant([]<typename Task>() -> const auto& { return Task::GetFilteredResourceInfos(); });
+	}
+
+	// true if the task uses the resources of a derived class instead of the fallback
+	bool IsNarrowed() const { return variantIdx < sizeof...(Variants); }
+
+private:
+	// index into Variants, sizeof...(Variants) selects the fallback
+	const size_t variantIdx;
+
+	template <size_t... Idx>
+	static size_t SelectVariant(const std::type_info& dynamic_type, std::index_sequence<Idx...>)
+	{
+		size_t selected = sizeof...(Variants);
+		// take the first variant matching the exact dynamic type
+		((selected = selected == sizeof...(Variants) && dynamic_type == typeid(typename Variants::TClass)
+			             ? Idx
+			             : selected), ...);
+		return selected;
+	}
+
+	// calls the lambda with the CTask type of the selected variant
+	template <typename F>
+	decltype(auto) VisitVariant(F&& call_with) const
+	{
+		return VisitVariantImpl<0>(std::forward<F>(call_with));
+	}
+
+	template <size_t Idx, typename F>
+	decltype(auto) VisitVariantImpl(F&& call_with) const
+	{
+		if constexpr (Idx == sizeof...(Variants))
+			return std::forward<F>(call_with).template operator()<FallbackTask>();
+		else
+		{
+			using TVariantTask = typename std::tuple_element_t<Idx, std::tuple<Variants...>>::TTask;
+			if (variantIdx == Idx)
+				return std::forward<F>(call_with).template operator()<TVariantTask>();
+			return VisitVariantImpl<Idx + 1>(std::forward<F>(call_with));
+		}
+	}
+};
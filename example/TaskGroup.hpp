@@ -0,0 +1,52 @@
+#pragma once
+#include <memory>
+
+#include "CStreamingTaskScheduler.h"
+#include "ITaskExecutor.h"
+#include "Task.hpp"
+
+/**
+ * \brief Fork-join subtasks spawned from inside of a running task.
+ *        The subtasks may only access resources of the parent task, which is checked at compile time,
+ *        so they never conflict with the tasks running next to the parent and only have to be ordered among each other.
+ *        Conflicting subtasks are executed in spawn order, the others run in parallel on the worker pool.
+ *        Joining helps executing jobs of the pool instead of blocking the thread of the parent task.
+ * \tparam ParentTask CTask or CMethodResources of the task spawning the subtasks
+ */
+template <Meta::filtered_resources_provider ParentTask>
+class CTaskGroup
+{
+public:
+	/**
+	 * \param executor Pool or other executor executing the subtasks, usually the one of the scheduler running the parent task
+	 */
+	explicit CTaskGroup(ITaskExecutor& executor)
+		: scheduler(executor)
+	{
+	}
+
+	// joins all spawned subtasks
+	~CTaskGroup() { Join(); }
+
+	CTaskGroup(const CTaskGroup&) = delete;
+	CTaskGroup& operator=(const CTaskGroup&) = delete;
+
+	/**
+	 * \brief Starts a subtask, as soon as the conflicting subtasks spawned before it are finished.
+	 * \tparam MethodAnnotations List of method resources of the subtask, a subset of the parent's resources
+	 * \param function The subtask
+	 */
+	template <Meta::method_resources... MethodAnnotations>
+	void Spawn(ITask::TTaskFunction&& function)
+	{
+		static_assert(Meta::resource_subset_v<CTask<MethodAnnotations...>, ParentTask>,
+		              "A subtask may only access resources of its parent task and only write the ones the parent writes.");
+		scheduler.Submit(std::make_shared<CTask<MethodAnnotations...>>(std::move(function)));
+	}
+
+	// waits for all spawned subtasks, executing pending jobs in the meantime
+	void Join() { scheduler.HelpUntilIdle(); }
+
+private:
+	CStreamingTaskScheduler scheduler;
+};
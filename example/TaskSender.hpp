@@ -0,0 +1,218 @@
+#pragma once
+#include <cassert>
+#include <concepts>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <type_traits>
+#include <utility>
+
+#include "CTaskScheduler.h"
+#include "Task.hpp"
+
+/**
+ * \brief Checks if we have a receiver of a sender, which takes the values of the sender once it completed.
+ * \tparam Receiver The type to check
+ * \tparam Values Types of the values of the sender, none for senders without a value
+ */
+template <typename Receiver, typename... Values>
+concept task_receiver = requires(Receiver receiver, Values&&... values)
+{
+	std::move(receiver).SetValue(std::forward<Values>(values)...);
+};
+
+/**
+ * \brief Checks if we have a sender: a description of work, started by connecting it to a receiver.
+ * \tparam Sender The type to check
+ */
+template <typename Sender>
+concept task_sender = requires { typename std::remove_cvref_t<Sender>::TValue; }
+	&& std::is_object_v<std::remove_cvref_t<Sender>>;
+
+/**
+ * \brief Started batch of a CScheduleSender, completes the receiver with the deferred tasks of the batch.
+ * \tparam Receiver Receiver of the deferred tasks
+ */
+template <typename Receiver>
+class CScheduleOperation
+{
+public:
+	using TTaskQueue = std::queue<std::shared_ptr<ITask>>;
+
+	CScheduleOperation(CTaskScheduler& scheduler, TTaskQueue&& task_queue, const CTaskScheduler::TCost time_budget,
+	                   Receiver&& receiver)
+		: scheduler(scheduler)
+		, taskQueue(std::move(task_queue))
+		, timeBudget(time_budget)
+		, receiver(std::move(receiver))
+	{
+	}
+
+	// executes the batch and completes the receiver, at most once
+	void Start()
+	{
+		TTaskQueue deferredTasks = scheduler.OrderAndExecuteTasks(std::move(taskQueue), timeBudget);
+		std::move(receiver).SetValue(std::move(deferredTasks));
+	}
+
+private:
+	CTaskScheduler& scheduler;
+	TTaskQueue taskQueue;
+	CTaskScheduler::TCost timeBudget;
+	Receiver receiver;
+};
+
+/**
+ * \brief Sender executing a batch on a scheduler, with the deferred tasks of the batch as its value.
+ *        The batch runs on the thread starting the operation, which helps the executor of the scheduler,
+ *        so the following steps continue on that thread without a hop to another one.
+ */
+class CScheduleSender
+{
+public:
+	using TValue = std::queue<std::shared_ptr<ITask>>;
+
+	/**
+	 * \param scheduler Scheduler executing the batch, has to outlive the operation
+	 * \param task_queue The tasks of the batch, conflicting tasks are executed in queue order
+	 * \param time_budget Time budget of the batch, see CTaskScheduler::OrderAndExecuteTasks
+	 */
+	CScheduleSender(CTaskScheduler& scheduler, TValue task_queue, const CTaskScheduler::TCost time_budget)
+		: scheduler(scheduler)
+		, taskQueue(std::move(task_queue))
+		, timeBudget(time_budget)
+	{
+	}
+
+	template <task_receiver<TValue> Receiver>
+	CScheduleOperation<std::remove_cvref_t<Receiver>> Connect(Receiver&& receiver) &&
+	{
+		return {scheduler, std::move(taskQueue), timeBudget, std::remove_cvref_t<Receiver>(std::forward<Receiver>(receiver))};
+	}
+
+private:
+	CTaskScheduler& scheduler;
+	TValue taskQueue;
+	CTaskScheduler::TCost timeBudget;
+};
+
+/**
+ * \brief Sender passing the value of another sender through a function, its value is the result of the function.
+ * \tparam Sender The preceding sender
+ * \tparam Function Called with the value of the preceding sender
+ */
+template <task_sender Sender, typename Function>
+class CThenSender
+{
+public:
+	using TInput = typename Sender::TValue;
+	using TValue = typename std::conditional_t<std::is_void_v<TInput>,
+	                                           std::invoke_result<Function>,
+	                                           std::invoke_result<Function, TInput>>::type;
+
+	CThenSender(Sender sender, Function function)
+		: sender(std::move(sender))
+		, function(std::move(function))
+	{
+	}
+
+	template <typename Receiver>
+	auto Connect(Receiver&& receiver) &&
+	{
+		return std::move(sender).Connect(CReceiver<std::remove_cvref_t<Receiver>>{
+			std::move(function), std::forward<Receiver>(receiver)
+		});
+	}
+
+private:
+	// calls the function with the value of the preceding sender and hands the result on
+	template <typename Receiver>
+	struct CReceiver
+	{
+		Function function;
+		Receiver receiver;
+
+		template <typename... Values>
+		void SetValue(Values&&... values) &&
+		{
+			if constexpr (std::is_void_v<TValue>)
+			{
+				std::invoke(function, std::forward<Values>(values)...);
+				std::move(receiver).SetValue();
+			}
+			else
+				std::move(receiver).SetValue(std::invoke(function, std::forward<Values>(values)...));
+		}
+	};
+
+	Sender sender;
+	Function function;
+};
+
+// result of Then, waits to be piped into a sender
+template <typename Function>
+struct CThenAdaptor
+{
+	Function function;
+};
+
+/**
+ * \brief Describes the execution of a batch, see CScheduleSender.
+ *        Nothing is executed before the sender is connected and started, e.g. by SyncWait.
+ */
+inline CScheduleSender Schedule(CTaskScheduler& scheduler, std::queue<std::shared_ptr<ITask>> task_queue,
+                                const CTaskScheduler::TCost time_budget = CTaskScheduler::TCost::max())
+{
+	return CScheduleSender(scheduler, std::move(task_queue), time_budget);
+}
+
+/**
+ * \brief Continues a sender with a function, piped like `Schedule(scheduler, tasks) | Then(function)`.
+ */
+template <typename Function>
+CThenAdaptor<std::decay_t<Function>> Then(Function&& function)
+{
+	return {std::forward<Function>(function)};
+}
+
+template <task_sender Sender, typename Function>
+CThenSender<std::remove_cvref_t<Sender>, Function> operator|(Sender&& sender, CThenAdaptor<Function>&& adaptor)
+{
+	return {std::forward<Sender>(sender), std::move(adaptor.function)};
+}
+
+// stores the value of the sender for SyncWait, bool for senders without a value
+template <typename Value>
+struct CSyncWaitReceiver
+{
+	using TResult = std::conditional_t<std::is_void_v<Value>, bool, Value>;
+
+	std::optional<TResult>* pResult;
+
+	template <typename... Values>
+	void SetValue(Values&&... values) &&
+	{
+		if constexpr (std::is_void_v<Value>)
+			pResult->emplace(true);
+		else
+			pResult->emplace(std::forward<Values>(values)...);
+	}
+};
+
+/**
+ * \brief Starts the sender and blocks until it completed.
+ * \return The value of the sender
+ */
+template <task_sender Sender>
+typename std::remove_cvref_t<Sender>::TValue SyncWait(Sender&& sender)
+{
+	using TValue = typename std::remove_cvref_t<Sender>::TValue;
+	std::optional<typename CSyncWaitReceiver<TValue>::TResult> result;
+	auto operation = std::remove_cvref_t<Sender>(std::forward<Sender>(sender)).Connect(CSyncWaitReceiver<TValue>{&result});
+	// the senders complete on the starting thread
+	operation.Start();
+	assert(result.has_value() && "The sender did not complete.");
+	if constexpr (!std::is_void_v<TValue>)
+		return std::move(*result);
+}
@@ -8,7 +8,12 @@
  * function to check on used resources.
  */
 
+#include <algorithm>
 #include <any>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
 #include <functional>
 #include <iostream>
 #include <MetaResourceVisitor.hpp>
@@ -17,9 +22,24 @@
 #include <tuple>
 #include <vector>
 
+#include "CFalseSharingAnalyzer.h"
+#include "CScheduleSimulator.h"
+#include "CStaticTaskScheduler.hpp"
+#include "CStreamingTaskScheduler.h"
+#include "CBarFoo.h"
+#include "CCpuTopology.h"
+#include "CFooBar.h"
+#include "CIncrementalTaskGraph.h"
+#include "CInlineExecutor.h"
 #include "CTaskScheduler.h"
+#include "CTaskTimer.h"
+#include "CoroutineTask.hpp"
+#include "DataflowTask.hpp"
 #include "MetaResourceList.h"
+#include "ParallelTask.hpp"
 #include "Task.hpp"
+#include "TaskGroup.hpp"
+#include "TaskSender.hpp"
 
 // Test structures to test the concepts forward_declared_type and complete_type
 class CIncomplete; // Forward declaration
@@ -29,6 +49,12 @@ class CComplete
 	int data = 0;
 };
 
+// Test structure for method resources with a declared cost
+struct CCostlyMethod : Meta::CMethodResources<Meta::Bar::CPublicReadSomeString>
+{
+	static constexpr std::chrono::microseconds ESTIMATED_COST{50};
+};
+
 int main()
 {
 	/***************
@@ -127,6 +153,40 @@ int main()
 	static_assert( // CSomeNumber<EResourceAccessMode::WRITE>
 		std::get<0>(fooMethodC).ACCESS_MODE == Meta::EResourceAccessMode::WRITE
 	);
+	// check conflicts between method resources
+	static_assert(Meta::conflicts_v<Meta::Bar::CMethod, Meta::Foo::CReadSomeString>);
+	static_assert(!Meta::conflicts_v<Meta::Bar::CMethod, Meta::Bar::CSetAnotherString>);
+	static_assert(!Meta::conflicts_v<Meta::Bar::CPublicReadSomeString, Meta::Foo::CReadSomeString>); // read only
+	static_assert(std::is_same_v<Meta::TConflictingResources<Meta::Bar::CMethod, Meta::Foo::CReadSomeString>,
+	                             std::tuple<TSomeStringWrite, TSomeStringRead>>);
+	static_assert(std::is_same_v<Meta::TConflictingResources<Meta::Bar::CMethod, Meta::Bar::CSetAnotherString>,
+	                             std::tuple<>>);
+	// check declared costs
+	static_assert(Meta::cost_annotated<CCostlyMethod> && !Meta::cost_annotated<Meta::Bar::CMethod>);
+	static_assert(CTask<CCostlyMethod, Meta::Bar::CMethod>::DECLARED_COST == std::chrono::microseconds(50));
+	static_assert(!CTask<Meta::Bar::CMethod>::DECLARED_COST.has_value());
+	// check resource subsets for subtasks
+	static_assert(Meta::resource_subset_v<Meta::Bar::CMethod, Meta::Foo::CMethodC>);
+	static_assert(Meta::resource_subset_v<Meta::Bar::CPublicReadSomeString, Meta::Bar::CMethod>); // read under write
+	static_assert(!Meta::resource_subset_v<Meta::Bar::CPublicWriteSomeString, Meta::Bar::CPublicReadSomeString>);
+	static_assert(!Meta::resource_subset_v<Meta::Foo::CMethodA, Meta::Bar::CMethod>); // Foo::number is missing
+	static_assert(Meta::resource_subset_v<Meta::CNoResources, Meta::Bar::CMethod>);
+	// check accesses to whole objects
+	using TBarObjectRead = Meta::Bar::CObject<Meta::EResourceAccessMode::READ>;
+	using TBarObjectWrite = Meta::Bar::CObject<Meta::EResourceAccessMode::WRITE>;
+	static_assert(Meta::conflicts_v<Meta::Bar::CReset, Meta::Bar::CPublicReadSomeNumber>);
+	static_assert(Meta::conflicts_v<Meta::Bar::CPrint, Meta::Bar::CPublicWriteSomeString>);
+	static_assert(!Meta::conflicts_v<Meta::Bar::CPrint, Meta::Bar::CPublicReadSomeString>); // read only
+	static_assert(std::is_same_v<decltype(CTask<Meta::Bar::CReset, Meta::Bar::CMethod>::GetFilteredResources()),
+	                             std::tuple<TBarObjectWrite>>); // members implied by the object
+	static_assert(std::is_same_v<decltype(CTask<Meta::Bar::CPrint, Meta::Bar::CPublicReadSomeNumber>::GetFilteredResources()),
+	                             std::tuple<TBarObjectRead>>);
+	static_assert(Meta::resource_subset_v<Meta::Bar::CMethod, Meta::Bar::CReset>);
+	static_assert(!Meta::resource_subset_v<Meta::Bar::CReset, Meta::Bar::CMethod>);
+	static_assert(!Meta::resource_subset_v<Meta::Bar::CPublicWriteSomeNumber, Meta::Bar::CPrint>);
+	// check inputs of dataflow tasks
+	static_assert(task_input<const std::vector<int>&> && task_input<std::vector<int>&&>);
+	static_assert(!task_input<std::vector<int>&> && !task_input<std::vector<int>>);
 
 	/***************
 	 * Runtime tests
@@ -221,6 +281,24 @@ int main()
 	using TTaskE = CTask<Meta::Foo::CMethodA, Meta::Foo::CMethodB, Meta::Foo::CMethodC>;
 	auto taskE = std::make_shared<TTaskE>(std::move(funE));
 
+	// check conflicts between tasks and method resources
+	static_assert(Meta::conflicts_v<TTaskA, TTaskB>);
+	static_assert(Meta::conflicts_v<TTaskE, Meta::Bar::CSetAnotherString>);
+	static_assert(!Meta::conflicts_v<TTaskD, TTaskE>);
+	static_assert(std::is_same_v<Meta::TConflictingResources<TTaskB, TTaskC>, std::tuple<>>);
+
+	// check the compile-time schedule of our tasks
+	// edges: A -> B (Bar::someString), B -> E and C -> E, A -> E (Foo::number) is implied by A -> B -> E
+	using TStaticScheduler = CStaticTaskScheduler<TTaskA, TTaskB, TTaskC, TTaskD, TTaskE>;
+	using TSchedule = TStaticScheduler::TSchedule;
+	static_assert(!TSchedule::CONCURRENT<TTaskA, TTaskB>);
+	static_assert(TSchedule::CONCURRENT<TTaskA, TTaskC>);
+	static_assert(TSchedule::EDGES[TSchedule::INDEX_OF<TTaskA>][TSchedule::INDEX_OF<TTaskB>]);
+	static_assert(!TSchedule::EDGES[TSchedule::INDEX_OF<TTaskA>][TSchedule::INDEX_OF<TTaskE>]);
+	static_assert(TSchedule::IN_DEGREES[TSchedule::INDEX_OF<TTaskE>] == 2);
+	static_assert(TSchedule::LEVELS[TSchedule::INDEX_OF<TTaskE>] == 2);
+	static_assert(TSchedule::DEPTH <= 3);
+
 	// Add tasks to our scheduler queue and task list
 	// Conflicts: taskA and taskB, because funA wants to read Bar::someString while funB tries to write it
 	std::queue<std::shared_ptr<ITask>> schedulerTaskQueue;
@@ -317,8 +395,396 @@ int main()
 	// Task D has no conflicts and can run in parallel with all tasks
 	std::cout << "" << std::endl;
 	std::cout << "Executing tasks:" << std::endl;
-	CTaskScheduler taskScheduler{};
+	// costs measured in previous runs, tuning priorities and fusion from the first batch on,
+	// saved again when the scheduler is destroyed
+	const std::filesystem::path costDatabasePath = std::filesystem::temp_directory_path() / "task_costs.db";
+	CTaskScheduler taskScheduler{std::thread::hardware_concurrency(), 0, nullptr, costDatabasePath};
 	taskScheduler.OrderAndExecuteTasks(schedulerTaskQueue);
 
+	// Same tasks again, but ordered at compile time
+	std::cout << "" << std::endl;
+	std::cout << "Executing tasks with static schedule:" << std::endl;
+	TStaticScheduler::ExecuteTasks(taskA, taskB, taskC, taskD, taskE);
+
+	// Task F and G write different members of CBar and may run in parallel,
+	// but Bar::someNumber and Bar::someString share a cache line
+	using TTaskF = CTask<Meta::Bar::CPublicWriteSomeNumber>;
+	using TTaskG = CTask<Meta::Bar::CPublicWriteSomeString>;
+	const std::vector<std::shared_ptr<ITask>> falseSharingTasks{
+		std::make_shared<TTaskF>([&]() { myBar->someNumber = 2; }),
+		std::make_shared<TTaskG>([&]() { myBar->someString = "False sharing"; })
+	};
+	std::cout << "" << std::endl;
+	std::cout << "Checking for false sharing:" << std::endl;
+	CFalseSharingAnalyzer::PrintReport(std::cout, falseSharingTasks,
+	                                   CFalseSharingAnalyzer::Analyze(falseSharingTasks));
+
+	// Task H declares write access on Bar::someNumber and Bar::someString, but only writes Bar::someString,
+	// so the tracer reports Bar::someNumber, which orders task H before task I for no reason
+	using TTaskH = CTask<Meta::Bar::CMethod>;
+	using TTaskI = CTask<Meta::Bar::CPublicReadSomeNumber>;
+	const std::vector<std::shared_ptr<ITask>> tracedTasks{
+		std::make_shared<TTaskH>([&]() { myBar->someString = "Traced"; }),
+		std::make_shared<TTaskI>([&]() { std::cout << "Bar number: " << myBar->someNumber << "\n"; })
+	};
+	CAccessTracer accessTracer{};
+	accessTracer.Watch(*myBar);
+	taskScheduler.SetAccessTracer(&accessTracer);
+	std::cout << "" << std::endl;
+	std::cout << "Tracing write accesses:" << std::endl;
+	std::queue<std::shared_ptr<ITask>> tracedTaskQueue;
+	for (auto&& task : tracedTasks)
+		tracedTaskQueue.push(task);
+	taskScheduler.OrderAndExecuteTasks(tracedTaskQueue);
+	taskScheduler.SetAccessTracer(nullptr);
+	CAccessTracer::PrintReport(std::cout, accessTracer.GetDowngrades(tracedTasks));
+
+	// Virtual method called through IFooBar:
+	// the union of all derived resources writes IFooBar::fooBarNum, CBarFoo::VirtualMethod only reads it,
+	// so both tasks on a CBarFoo object can run in parallel once the resources are narrowed
+	static_assert(Meta::conflicts_v<Meta::FooBar::IFooBarVirtualMethod, Meta::FooBar::IFooBarVirtualMethod>);
+	static_assert(!Meta::conflicts_v<Meta::FooBar::CBarFooVirtualMethod, Meta::FooBar::CBarFooVirtualMethod>);
+	using TVirtualTask = CVirtualTask<IFooBar,
+	                                  CTask<Meta::FooBar::IFooBarVirtualMethod>,
+	                                  CResourceVariant<CFooBar, CTask<Meta::FooBar::CFooBarVirtualMethod>>,
+	                                  CResourceVariant<CBarFoo, CTask<Meta::FooBar::CBarFooVirtualMethod>>>;
+	const std::unique_ptr<IFooBar> myBarFoo = std::make_unique<CBarFoo>();
+	std::queue<std::shared_ptr<ITask>> virtualTaskQueue;
+	for (int idx = 0; idx < 2; ++idx)
+	{
+		virtualTaskQueue.push(std::make_shared<TVirtualTask>(*myBarFoo, [&]()
+		{
+			std::cout << "Virtual method: " << myBarFoo->VirtualMethod() << "\n";
+		}));
+	}
+	std::cout << "" << std::endl;
+	std::cout << "Executing virtual tasks:" << std::endl;
+	taskScheduler.OrderAndExecuteTasks(virtualTaskQueue);
+
+	// Fusion of tiny tasks: the declared costs of A, B and C are below the threshold,
+	// so the chain A -> B is fused into one execution unit
+	taskA->SetEstimatedCost(microseconds(10));
+	taskB->SetEstimatedCost(microseconds(10));
+	taskC->SetEstimatedCost(microseconds(10));
+	taskScheduler.SetFusionThreshold(microseconds(50));
+	std::queue<std::shared_ptr<ITask>> fusedTaskQueue;
+	for (auto&& task : tasks)
+		fusedTaskQueue.push(task);
+	std::cout << "" << std::endl;
+	std::cout << "Executing fused tasks:" << std::endl;
+	taskScheduler.OrderAndExecuteTasks(fusedTaskQueue);
+	std::cout << "Fusion ratio: " << taskScheduler.GetStats().GetFusionRatio() << std::endl;
+	std::cout << "Critical path: " << taskScheduler.GetStats().criticalPathCost.count() << "ns" << std::endl;
+	taskScheduler.SetFusionThreshold(CTaskScheduler::TCost::zero());
+
+	// Data-parallel task: one vertex in the graph, its range is executed in chunks across the worker pool
+	std::vector<int> numbers(1000, 1);
+	std::atomic<int> sum = 0;
+	using TParallelTask = CParallelTask<CIndexRange<size_t>, Meta::Bar::CPublicReadSomeNumber>;
+	auto parallelTask = std::make_shared<TParallelTask>(
+		taskScheduler.GetExecutor(), CIndexRange<size_t>{0, numbers.size()}, [&](const CIndexRange<size_t> chunk)
+		{
+			int chunkSum = 0;
+			for (size_t idx = chunk.begin; idx < chunk.end; ++idx)
+				chunkSum += numbers[idx] * myBar->someNumber;
+			sum += chunkSum;
+		});
+	std::queue<std::shared_ptr<ITask>> parallelTaskQueue;
+	parallelTaskQueue.push(parallelTask);
+	taskScheduler.OrderAndExecuteTasks(parallelTaskQueue);
+	std::cout << "" << std::endl;
+	std::cout << "Parallel task sum: " << sum << std::endl;
+
+	// Lanes: task D is background work and only runs on otherwise idle workers,
+	// task E is latency-critical, so A, B and C it waits for inherit its lane
+	taskD->SetLane(ETaskLane::BACKGROUND);
+	taskE->SetLane(ETaskLane::HIGH);
+	std::queue<std::shared_ptr<ITask>> laneTaskQueue;
+	for (auto&& task : tasks)
+		laneTaskQueue.push(task);
+	std::cout << "" << std::endl;
+	std::cout << "Executing tasks in lanes:" << std::endl;
+	taskScheduler.OrderAndExecuteTasks(laneTaskQueue);
+	taskD->SetLane(ETaskLane::NORMAL);
+	taskE->SetLane(ETaskLane::NORMAL);
+
+	// Frame budget: task D is deferrable and takes longer than the budget, so it is handed back to the next frame
+	taskD->SetDeferrable(true);
+	std::queue<std::shared_ptr<ITask>> budgetTaskQueue;
+	for (auto&& task : tasks)
+		budgetTaskQueue.push(task);
+	std::cout << "" << std::endl;
+	std::cout << "Executing tasks within a budget:" << std::endl;
+	std::queue<std::shared_ptr<ITask>> carryOverQueue = taskScheduler.OrderAndExecuteTasks(
+		std::move(budgetTaskQueue), milliseconds(16));
+	std::cout << "Deferred tasks: " << taskScheduler.GetStats().numDeferredTasks << std::endl;
+	// the carry-over batch goes first into the next frame
+	taskScheduler.OrderAndExecuteTasks(std::move(carryOverQueue));
+	taskD->SetDeferrable(false);
+
+	// Affinity: ready tasks are placed on the worker which last wrote their resources
+	taskScheduler.SetResourceAffinity(true);
+	taskScheduler.GetWorkerPool().ResetAffinityStats();
+	std::queue<std::shared_ptr<ITask>> affinityTaskQueue;
+	for (auto&& task : tasks)
+		affinityTaskQueue.push(task);
+	std::cout << "" << std::endl;
+	std::cout << "Executing tasks with resource affinity:" << std::endl;
+	taskScheduler.OrderAndExecuteTasks(std::move(affinityTaskQueue));
+	const CWorkerPool::CAffinityStats affinityStats = taskScheduler.GetWorkerPool().GetAffinityStats();
+	std::cout << "Affinity hits: " << affinityStats.numHits << ", misses: " << affinityStats.numMisses
+		<< ", unplaced: " << affinityStats.numUnplaced << std::endl;
+	taskScheduler.SetResourceAffinity(false);
+
+	// Topology: the workers are spread over the nodes and steal within their node first,
+	// 4 workers on two nodes with 4 CPUs each use both nodes
+	const std::vector<std::pair<size_t, size_t>> fakeAssignments = CCpuTopology({{0, {0, 1, 2, 3}}, {1, {4, 5, 6, 7}}})
+		.AssignWorkers(4);
+	const bool spreadOverNodes = fakeAssignments
+		== std::vector<std::pair<size_t, size_t>>{{0, 0}, {1, 4}, {0, 1}, {1, 5}};
+	assert(spreadOverNodes && "The workers have to be spread over the nodes.");
+	std::cout << "" << std::endl;
+	std::cout << "Workers spread over the nodes: " << std::boolalpha << spreadOverNodes << std::noboolalpha << std::endl;
+
+	// the last task is placed on the last node
+	const CCpuTopology topology{};
+	CTaskScheduler pinnedScheduler(std::thread::hardware_concurrency(), 0, &topology);
+	std::queue<std::shared_ptr<ITask>> pinnedTaskQueue;
+	for (auto&& task : tasks)
+		pinnedTaskQueue.push(task);
+	tasks.back()->SetNodeHint(topology.GetNumNodes() - 1);
+	std::cout << "" << std::endl;
+	std::cout << "Executing tasks on " << topology.GetNumNodes() << " node(s):" << std::endl;
+	pinnedScheduler.OrderAndExecuteTasks(std::move(pinnedTaskQueue));
+	tasks.back()->SetNodeHint(CCpuTopology::NO_NODE);
+	const CWorkerPool::CStealStats stealStats = pinnedScheduler.GetWorkerPool().GetStealStats();
+	std::cout << "Pinned workers: " << pinnedScheduler.GetWorkerPool().GetNumPinnedWorkers()
+		<< ", local steals: " << stealStats.numLocalSteals
+		<< ", remote steals: " << stealStats.numRemoteSteals << std::endl;
+
+	// Simulation with the measured costs: speedup on up to 4 cores and the resources worth splitting
+	std::cout << "" << std::endl;
+	std::cout << "Simulated schedule:" << std::endl;
+	constexpr size_t simulatedCores = 4;
+	const std::vector<CScheduleSimulator::CResult> simulatedResults = CScheduleSimulator::SimulateSpeedup(
+		tasks, simulatedCores);
+	CScheduleSimulator::PrintReport(std::cout, simulatedResults,
+	                                CScheduleSimulator::ComputeResourceIdleTimes(tasks, simulatedCores));
+	// hold by construction for any costs: one core executes all tasks back to back,
+	// more cores never beat the critical path nor execute more work than they have time for
+	const bool consistentSimulation = simulatedResults.front().makespan == simulatedResults.front().totalWork
+		&& std::ranges::all_of(simulatedResults, [](const CScheduleSimulator::CResult& result)
+		{
+			return result.makespan >= result.criticalPath
+				&& result.makespan * static_cast<ITask::TCost::rep>(result.numCores) >= result.totalWork;
+		});
+	assert(consistentSimulation && "The simulated makespans violate their bounds.");
+	std::cout << "Simulation within bounds: " << std::boolalpha << consistentSimulation << std::noboolalpha << std::endl;
+
+	// Streaming submission: every task starts as soon as its conflicting predecessors are done
+	std::cout << "" << std::endl;
+	std::cout << "Streaming tasks:" << std::endl;
+	CStreamingTaskScheduler streamingScheduler{};
+	for (auto&& task : tasks)
+		streamingScheduler.Submit(task);
+	streamingScheduler.WaitIdle();
+
+	// Pipelined frames: the second frame starts while the long task D of the first frame is still running,
+	// since task D does not conflict with any other task
+	std::cout << "" << std::endl;
+	std::cout << "Pipelining frames:" << std::endl;
+	streamingScheduler.SetMaxFramesInFlight(2);
+	for (int frame = 0; frame < 2; ++frame)
+	{
+		std::queue<std::shared_ptr<ITask>> frameTaskQueue;
+		for (auto&& task : tasks)
+			frameTaskQueue.push(task);
+		streamingScheduler.SubmitFrame(std::move(frameTaskQueue));
+	}
+	streamingScheduler.WaitIdle();
+
+	// Nested subtasks: the parent task splits its work into subtasks using a subset of its resources,
+	// the write of someNumber and the read of someNumber are ordered, setting anotherString runs next to them
+	std::cout << "" << std::endl;
+	std::cout << "Nested subtasks:" << std::endl;
+	using TParentTask = CTask<Meta::Foo::CMethodC>;
+	streamingScheduler.Submit(std::make_shared<TParentTask>([&]()
+	{
+		CTaskGroup<TParentTask> subTasks(streamingScheduler.GetExecutor());
+		subTasks.Spawn<Meta::Bar::CPublicWriteSomeNumber>([&]() { myBar->someNumber = 2; });
+		subTasks.Spawn<Meta::Bar::CPublicReadSomeNumber>([&]()
+		{
+			std::cout << "Subtask read someNumber: " << myBar->someNumber << "\n";
+		});
+		subTasks.Spawn<Meta::Bar::CSetAnotherString>([&]() { myBar->SetAnotherString("Subtask"); });
+		subTasks.Join();
+		std::cout << "Parent task joined its subtasks\n";
+	}));
+	streamingScheduler.WaitIdle();
+
+	// Whole objects: printing reads all of CBar and waits for the member writes before it,
+	// resetting writes all of CBar and waits for the print, the reads of different members run in parallel
+	std::cout << "" << std::endl;
+	std::cout << "Accessing whole objects:" << std::endl;
+	const std::vector<std::shared_ptr<ITask>> objectTasks{
+		std::make_shared<CTask<Meta::Bar::CPublicWriteSomeNumber>>([&]() { myBar->someNumber = 3; }),
+		std::make_shared<CTask<Meta::Bar::CPrint>>([&]()
+		{
+			std::cout << "Bar: " << myBar->someNumber << ", " << myBar->someString << "\n";
+		}),
+		std::make_shared<CTask<Meta::Bar::CReset>>([&]() { *myBar = CBar(); }),
+		std::make_shared<CTask<Meta::Bar::CPublicReadSomeNumber>>([&]()
+		{
+			std::cout << "Bar number after reset: " << myBar->someNumber << "\n";
+		}),
+		std::make_shared<CTask<Meta::Bar::CPublicReadSomeString>>([&]()
+		{
+			std::cout << "Bar string after reset: " << myBar->someString << "\n";
+		})
+	};
+	std::queue<std::shared_ptr<ITask>> objectTaskQueue;
+	for (auto&& task : objectTasks)
+		objectTaskQueue.push(task);
+	taskScheduler.OrderAndExecuteTasks(std::move(objectTaskQueue));
+	for (auto&& task : objectTasks)
+		streamingScheduler.Submit(task);
+	streamingScheduler.WaitIdle();
+
+	// Dataflow: the samples are passed from the producer to the consumers without a shared member,
+	// the sum and the count only read them and run in parallel, the last consumer takes them over
+	std::cout << "" << std::endl;
+	std::cout << "Passing task outputs:" << std::endl;
+	using TSamples = std::vector<int>;
+	auto produceSamples = std::make_shared<CDataflowTask<TSamples(), Meta::CNoResources>>(
+		taskScheduler.GetResultArena(), []() { return TSamples(1000, 1); });
+	auto sumSamples = std::make_shared<CDataflowTask<int(const TSamples&), Meta::CNoResources>>(
+		taskScheduler.GetResultArena(), [](const TSamples& samples)
+		{
+			int sum = 0;
+			for (const int sample : samples)
+				sum += sample;
+			return sum;
+		}, produceSamples->GetOutput());
+	auto printSum = std::make_shared<CDataflowTask<void(const int&), Meta::Bar::CPublicWriteSomeNumber>>(
+		taskScheduler.GetResultArena(), [&](const int& sum)
+		{
+			myBar->someNumber = sum;
+			std::cout << "Sum of samples: " << sum << "\n";
+		}, sumSamples->GetOutput());
+	auto takeSamples = std::make_shared<CDataflowTask<void(TSamples&&), Meta::CNoResources>>(
+		taskScheduler.GetResultArena(), [](TSamples&& samples)
+		{
+			const TSamples ownSamples = std::move(samples);
+			std::cout << "Took over " << ownSamples.size() << " samples\n";
+		}, produceSamples->GetOutput());
+	std::queue<std::shared_ptr<ITask>> dataflowTaskQueue;
+	for (const std::shared_ptr<ITask>& task : std::initializer_list<std::shared_ptr<ITask>>{
+		     produceSamples, sumSamples, printSum, takeSamples
+	     })
+		dataflowTaskQueue.push(task);
+	taskScheduler.OrderAndExecuteTasks(std::move(dataflowTaskQueue));
+
+	std::cout << "" << std::endl;
+	std::cout << "Composing a batch on the calling thread:" << std::endl;
+	CInlineExecutor inlineExecutor;
+	CTaskScheduler inlineScheduler(inlineExecutor);
+	std::queue<std::shared_ptr<ITask>> inlineTaskQueue;
+	inlineTaskQueue.push(std::make_shared<CTask<Meta::Bar::CPublicWriteSomeNumber>>([&] { myBar->someNumber = 3; }));
+	inlineTaskQueue.push(std::make_shared<CTask<Meta::Bar::CPublicReadSomeNumber>>([&]
+	{
+		std::cout << "Read number: " << myBar->someNumber << "\n";
+	}));
+	const size_t numDeferredTasks = SyncWait(Schedule(inlineScheduler, std::move(inlineTaskQueue))
+		| Then([](std::queue<std::shared_ptr<ITask>>&& deferred_tasks) { return deferred_tasks.size(); }));
+	std::cout << "Deferred tasks: " << numDeferredTasks << std::endl;
+
+	std::cout << "" << std::endl;
+	std::cout << "Locking resources instead of building a graph:" << std::endl;
+	taskScheduler.SetLockModeThreshold(8);
+	std::atomic<int> lockedSum = 0;
+	std::queue<std::shared_ptr<ITask>> lockedTaskQueue;
+	for (int idx = 0; idx < 3; ++idx)
+	{
+		lockedTaskQueue.push(std::make_shared<CTask<Meta::Bar::CPublicWriteSomeNumber>>([&] { ++myBar->someNumber; }));
+		lockedTaskQueue.push(std::make_shared<CTask<Meta::Bar::CPublicReadSomeNumber>>([&]
+		{
+			lockedSum += myBar->someNumber;
+		}));
+	}
+	// locks all members of the bar accessed in the batch
+	lockedTaskQueue.push(std::make_shared<CTask<Meta::Bar::CPrint>>([&] { lockedSum += myBar->someNumber; }));
+	taskScheduler.OrderAndExecuteTasks(std::move(lockedTaskQueue));
+	std::cout << "Lock mode: " << taskScheduler.GetStats().lockMode
+		<< ", waits for a lock: " << taskScheduler.GetStats().numLockWaits << std::endl;
+	taskScheduler.SetLockModeThreshold(0);
+
+	std::cout << "" << std::endl;
+	std::cout << "Waiting inside of tasks:" << std::endl;
+	CTaskTimer taskTimer;
+	CTaskEvent readCompleted;
+	// suspends until the read completed, the reader below waits for it without blocking a worker
+	auto waitForRead = std::make_shared<CCoroutineTask<Meta::Bar::CPublicWriteSomeNumber>>(
+		taskScheduler.GetExecutor(), [&]() -> CTaskCoroutine
+		{
+			co_await readCompleted;
+			myBar->someNumber = 7;
+			std::cout << "Read completed\n";
+		});
+	auto readNumber = std::make_shared<CCoroutineTask<Meta::Bar::CPublicReadSomeNumber>>(
+		taskScheduler.GetExecutor(), [&]() -> CTaskCoroutine
+		{
+			std::cout << "Read number: " << myBar->someNumber << "\n";
+			co_return;
+		});
+	// stands in for the I/O, runs on the worker released by the waiting task
+	auto completeRead = std::make_shared<CCoroutineTask<Meta::CNoResources>>(
+		taskScheduler.GetExecutor(), [&]() -> CTaskCoroutine
+		{
+			co_await taskTimer.SleepFor(milliseconds(5));
+			std::cout << "Completing the read\n";
+			readCompleted.Signal();
+		});
+	std::queue<std::shared_ptr<ITask>> coroutineTaskQueue;
+	for (const std::shared_ptr<ITask>& task : std::initializer_list<std::shared_ptr<ITask>>{
+		     waitForRead, readNumber, completeRead
+	     })
+		coroutineTaskQueue.push(task);
+	taskScheduler.OrderAndExecuteTasks(std::move(coroutineTaskQueue));
+
+	std::cout << "" << std::endl;
+	std::cout << "Updating the graph between frames:" << std::endl;
+	CIncrementalTaskGraph frameGraph;
+	// compares every update with a full rebuild in debug builds
+	frameGraph.SetVerification(true);
+	auto setNumber = std::make_shared<CTask<Meta::Bar::CPublicWriteSomeNumber>>([&] { myBar->someNumber = 4; });
+	auto printNumber = std::make_shared<CTask<Meta::Bar::CPublicReadSomeNumber>>([&]
+	{
+		std::cout << "Frame number: " << myBar->someNumber << "\n";
+	});
+	auto printString = std::make_shared<CTask<Meta::Bar::CPublicReadSomeString>>([&]
+	{
+		std::cout << "Frame string: " << myBar->someString << "\n";
+	});
+	frameGraph.Insert(setNumber);
+	frameGraph.Insert(printNumber);
+	frameGraph.Insert(printString);
+	taskScheduler.OrderAndExecuteTasks(frameGraph);
+	// only the chains of the resources of the removed and the inserted task are updated,
+	// the increment is inserted in front of the print
+	frameGraph.Remove(*setNumber);
+	frameGraph.Insert(std::make_shared<CTask<Meta::Bar::CPublicWriteSomeNumber>>([&] { ++myBar->someNumber; }), 0);
+	taskScheduler.OrderAndExecuteTasks(frameGraph);
+	std::cout << "Tasks: " << frameGraph.GetNumTasks() << ", edges: " << frameGraph.GetNumEdges() << std::endl;
+
+	std::cout << "" << std::endl;
+	std::cout << "Finding serialization bottlenecks:" << std::endl;
+	// counted during the last batch, the resources starving the workers most come first
+	for (const CResourceContention::CResourceCounters& counters : taskScheduler.GetResourceContention().GetSnapshot())
+		std::cout << counters.className << "::" << counters.memberName << ": " << counters.numEdges << " edges, "
+			<< std::chrono::duration_cast<std::chrono::microseconds>(counters.starvedTime).count() << "us starved" << std::endl;
+
+	std::cout << "" << std::endl;
+	std::cout << "Saving costs of " << taskScheduler.GetCostDatabase()->GetNumEntries() << " task types" << std::endl;
+
 	return 0;
 }
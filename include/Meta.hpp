@@ -1,10 +1,13 @@
 #pragma once
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <concepts>
+#include <initializer_list>
 #include <string_view>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace Meta
 {
@@ -47,6 +50,21 @@ namespace Meta
 	template <typename T>
 	concept method_or_member_resources = method_resources<T> || member_resource_access<T>;
 
+	/**
+	 * \brief Checks if we have a type that provides its filtered resources at compile time,
+	 *        like CMethodResources or CTask.
+	 * \tparam T The type to check
+	 */
+	template <typename T>
+	concept filtered_resources_provider = requires { T::GetFilteredResources(); };
+	/**
+	 * \brief Checks if we have a method resource declaring its execution time,
+	 *        e.g. `static constexpr std::chrono::microseconds ESTIMATED_COST{50};`
+	 * \tparam T The type to check
+	 */
+	template <typename T>
+	concept cost_annotated = requires { { T::ESTIMATED_COST } -> std::convertible_to<std::chrono::nanoseconds>; };
+
 	template <typename T>
 	concept public_member_field = requires { typename T::TMemberType; };
 	template <typename T>
@@ -71,6 +89,7 @@ namespace Meta
 	struct CMemberPointerTraits<MemberType ClassType::*>
 	{
 		using TType = MemberType;
+		using TClassType = ClassType;
 	};
 
 	/**
@@ -80,6 +99,13 @@ namespace Meta
 	template <typename T>
 	using TMemberPointerTraits = typename CMemberPointerTraits<T>::TType;
 
+	/**
+	 * \brief Gives you the class type of a member pointer.
+	 * \tparam T The member pointer type.
+	 */
+	template <typename T>
+	using TMemberPointerClass = typename CMemberPointerTraits<T>::TClassType;
+
 	/**
 	 * \brief Helper struct to store a string literal in compile time.
 	 * \tparam N Size of the string literal. Usually the compiler can figure that out.
@@ -120,6 +146,88 @@ namespace Meta
 		return S;
 	}
 
+	namespace Detail
+	{
+		template <typename T>
+		constexpr std::string_view GetRawTypeName()
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			return __FUNCSIG__;
+#else
+			return __PRETTY_FUNCTION__;
+#endif
+		}
+
+		template <auto Value>
+		constexpr std::string_view GetRawValueName()
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			return __FUNCSIG__;
+#else
+			return __PRETTY_FUNCTION__;
+#endif
+		}
+
+		struct CNameProbe
+		{
+			int probeMember;
+		};
+
+		/**
+		 * \brief Cuts the name out of the signature, the signature of a known name gives the text around it.
+		 * \return Name or an empty string_view, if the compiler does not print the known name
+		 */
+		constexpr std::string_view CutName(const std::string_view raw_name, const std::string_view probe_raw_name,
+		                                   const std::string_view probe_name)
+		{
+			const size_t prefix = probe_raw_name.find(probe_name);
+			if (prefix == std::string_view::npos)
+				return {};
+			const size_t suffix = probe_raw_name.size() - prefix - probe_name.size();
+			if (raw_name.size() < prefix + suffix)
+				return {};
+			return raw_name.substr(prefix, raw_name.size() - prefix - suffix);
+		}
+	}
+
+	/**
+	 * \brief Gives you the readable name of a type at compile time, without the class-key MSVC prints.
+	 * \tparam T The type
+	 * \return Qualified name, e.g. "CBar" or "Meta::Bar::CPrint"
+	 */
+	template <typename T>
+	constexpr std::string_view GetTypeName()
+	{
+		std::string_view name = Detail::CutName(Detail::GetRawTypeName<T>(), Detail::GetRawTypeName<double>(), "double");
+		for (const std::string_view classKey : {std::string_view("class "), std::string_view("struct "),
+		                                        std::string_view("union "), std::string_view("enum ")})
+			if (name.starts_with(classKey))
+				name.remove_prefix(classKey.size());
+		return name;
+	}
+
+	/**
+	 * \brief Gives you the name of the member a member pointer refers to at compile time.
+	 * \tparam Value Member pointer
+	 * \return Unqualified name, e.g. "someNumber", empty if the compiler only prints the offset of the member
+	 */
+	template <auto Value>
+	constexpr std::string_view GetMemberPointerName()
+	{
+		// the class may be printed with or without its namespaces, but the member name ends right before the suffix
+		constexpr std::string_view probeName = "probeMember";
+		const std::string_view probeRawName = Detail::GetRawValueName<&Detail::CNameProbe::probeMember>();
+		const size_t probeEnd = probeRawName.rfind(probeName);
+		if (probeEnd == std::string_view::npos)
+			return {};
+		const size_t suffix = probeRawName.size() - probeEnd - probeName.size();
+		const std::string_view rawName = Detail::GetRawValueName<Value>();
+		const std::string_view qualifiedName = rawName.substr(0, rawName.size() - suffix);
+		const size_t nameBegin = qualifiedName.find_last_not_of(
+			"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_");
+		return qualifiedName.substr(nameBegin == std::string_view::npos ? 0 : nameBegin + 1);
+	}
+
 	/*
 	 * ####################################
 	 * resource definition
@@ -135,26 +243,53 @@ namespace Meta
 		WRITE
 	};
 
+	/**
+	 * \brief Marks the offset of a member as unknown.
+	 */
+	constexpr size_t UNKNOWN_MEMBER_OFFSET = static_cast<size_t>(-1);
+
 	/**
 	 * \brief Links to the member of some class.
 	 * \tparam Value Reference to the public data member
+	 * \tparam Offset Optional byte offset of the data member inside its class, usually offsetof(Class, member),
+	 *         e.g. for the cache line analysis
 	 */
-	template <auto Value>
+	template <auto Value, size_t Offset = UNKNOWN_MEMBER_OFFSET>
 	struct CPublicMember
 	{
 		using TMemberType = TMemberPointerTraits<decltype(Value)>;
+		using TClassType = TMemberPointerClass<decltype(Value)>;
+		static constexpr auto MEMBER_POINTER = Value;
+		static constexpr size_t MEMBER_OFFSET = Offset;
+
+		// readable name of the member, empty if the compiler does not print member pointers by name
+		static constexpr std::string_view GetMemberName()
+		{
+			return GetMemberPointerName<Value>();
+		}
 	};
 
 	/**
 	 * \brief Describes a protected or private member of some class, because you cannot reference the member directly.
 	 * \tparam Type Holds the type of the data member
 	 * \tparam Name Pass the name of the data member as string into the CStringLiteral helper struct
+	 * \tparam Offset Optional byte offset of the data member inside its class, e.g. for the cache line analysis
 	 */
-	template <typename Type, CStringLiteral Name>
+	template <typename Type, CStringLiteral Name, size_t Offset = UNKNOWN_MEMBER_OFFSET>
 	struct CMember
 	{
 		using TMemberType = std::decay_t<Type>;
 		static constexpr CStringLiteral MEMBER_NAME = Name;
+		static constexpr size_t MEMBER_OFFSET = Offset;
+	};
+
+	/**
+	 * \brief Stands for all members of a class at once, see CObjectResourceAccess.
+	 */
+	struct CAllMembers
+	{
+		using TMemberType = void;
+		static constexpr CStringLiteral MEMBER_NAME = "*"_sl;
 	};
 
 	/**
@@ -189,6 +324,18 @@ namespace Meta
 		}
 	};
 
+	/**
+	 * \brief Links the access mode with a whole object.
+	 *        It implies the access to every member of the class, so it conflicts with all member accesses
+	 *        of the class if one of them writes, without listing every member.
+	 * \tparam Class Class type
+	 * \tparam AccessMode Mode of access
+	 */
+	template <typename Class, EResourceAccessMode AccessMode>
+	struct CObjectResourceAccess : CMemberResourceAccess<Class, CAllMembers, AccessMode>
+	{
+	};
+
 	/*
 	 * ####################################
 	 * filter for unique types
@@ -244,6 +391,24 @@ namespace Meta
 	 * ####################################
 	 */
 
+	/**
+	 * \brief Checks if we have an access to the whole object, like CObjectResourceAccess.
+	 * \tparam T The type to check
+	 */
+	template <typename T>
+	concept object_resource_access = member_resource_access<T> && std::is_same_v<typename T::TMember, CAllMembers>;
+
+	/**
+	 * \brief Checks if two resource accesses touch the same member, directly or through an access to the whole object.
+	 * \tparam T The first resource access
+	 * \tparam U The second resource access
+	 */
+	template <typename T, typename U>
+	concept overlapping_access = member_resource_access<T> && member_resource_access<U>
+		&& std::is_same_v<typename T::TType, typename U::TType>
+		&& (std::is_same_v<typename T::TMember, typename U::TMember>
+			|| object_resource_access<T> || object_resource_access<U>);
+
 	/**
 	 * \brief Checks if we have already write access on the same resource.
 	 * \tparam T The resource with read access
@@ -255,6 +420,16 @@ namespace Meta
 		&& std::is_same_v<typename T::TMember, typename U::TMember>
 		&& T::ACCESS_MODE == EResourceAccessMode::READ && U::ACCESS_MODE == EResourceAccessMode::WRITE;
 
+	/**
+	 * \brief Checks if the member access T is already implied by the access U to the whole object.
+	 * \tparam T The member access to check
+	 * \tparam U To check if it accesses the whole object of the same class in the same or a stronger mode
+	 */
+	template <typename T, typename U>
+	concept implied_access = member_resource_access<T> && object_resource_access<U> && !object_resource_access<T>
+		&& std::is_same_v<typename T::TType, typename U::TType>
+		&& (T::ACCESS_MODE == EResourceAccessMode::READ || U::ACCESS_MODE == EResourceAccessMode::WRITE);
+
 	/**
 	 * \brief Holds the list of filtered types.
 	 *        Can also append the list if the incoming type meets the requirements.
@@ -267,11 +442,13 @@ namespace Meta
 
 		template <member_resource_access T, member_resource_access... Unfiltered>
 		static constexpr bool EXIST_WRITE = (exist_write_access<T, Unfiltered> || ...);
+		template <member_resource_access T, member_resource_access... Unfiltered>
+		static constexpr bool IMPLIED = (implied_access<T, Unfiltered> || ...);
 		template <member_resource_access T>
 		static constexpr bool READ = T::ACCESS_MODE == EResourceAccessMode::READ;
 
 		template <member_resource_access T, member_resource_access... Unfiltered>
-		using TAppendFiltered = std::conditional_t<READ<T> && EXIST_WRITE<T, Unfiltered...>,
+		using TAppendFiltered = std::conditional_t<(READ<T> && EXIST_WRITE<T, Unfiltered...>) || IMPLIED<T, Unfiltered...>,
 		                                           CFilteredResourceTypeList<Filtered...>,
 		                                           CFilteredResourceTypeList<T, Filtered...>>;
 
@@ -303,11 +480,119 @@ namespace Meta
 	/**
 	 * \brief Filters out types which access the same resource
 	 *        by removing the read access and keeping the write access.
+	 *        Member accesses implied by an access to the whole object are removed as well.
 	 * \tparam Ts List of resources to check
 	 */
 	template <member_resource_access... Ts>
 	using TResourceTypes = typename CResourceTypeList<std::tuple<Ts...>, Ts...>::TFilter;
 
+	/*
+	 * ####################################
+	 * conflict detection
+	 * ####################################
+	 */
+
+	/**
+	 * \brief Checks if two resource accesses may not happen at the same time,
+	 *        which is the case if both access the same member (or the whole object) and at least one of them writes it.
+	 * \tparam T The first resource access
+	 * \tparam U The second resource access
+	 */
+	template <typename T, typename U>
+	concept conflicting_access = overlapping_access<T, U>
+		&& (T::ACCESS_MODE == EResourceAccessMode::WRITE || U::ACCESS_MODE == EResourceAccessMode::WRITE);
+
+	/**
+	 * \brief True if the resource access T conflicts with any of the resource accesses Us.
+	 */
+	template <member_resource_access T, member_resource_access... Us>
+	constexpr bool CONFLICTS_WITH_ANY = (conflicting_access<T, Us> || ...);
+
+	/**
+	 * \brief Checks two resource tuples (e.g. from GetFilteredResources) for conflicting accesses.
+	 * \return true if at least one resource of the first tuple conflicts with one of the second tuple
+	 */
+	template <member_resource_access... Ts, member_resource_access... Us>
+	constexpr bool HasConflict(std::tuple<Ts...>, std::tuple<Us...>)
+	{
+		return (CONFLICTS_WITH_ANY<Ts, Us...> || ...);
+	}
+
+	/**
+	 * \brief True if A and B may not run at the same time.
+	 * \tparam A CMethodResources or CTask
+	 * \tparam B CMethodResources or CTask
+	 */
+	template <filtered_resources_provider A, filtered_resources_provider B>
+	constexpr bool conflicts_v = HasConflict(A::GetFilteredResources(), B::GetFilteredResources());
+
+	template <typename, typename>
+	struct CConflictingResourceList;
+
+	template <member_resource_access... Ts, member_resource_access... Us>
+	struct CConflictingResourceList<std::tuple<Ts...>, std::tuple<Us...>>
+	{
+		// keeps every T that conflicts with one of Us
+		using TTypes = decltype(std::tuple_cat(
+			std::declval<std::conditional_t<CONFLICTS_WITH_ANY<Ts, Us...>, std::tuple<Ts>, std::tuple<>>>()...
+		));
+	};
+
+	/**
+	 * \brief Lists the resources causing a conflict between A and B.
+	 *        First the conflicting resources of A, followed by the conflicting resources of B.
+	 * \tparam A CMethodResources or CTask
+	 * \tparam B CMethodResources or CTask
+	 * \return std::tuple<Resources...>, empty if A and B do not conflict
+	 */
+	template <filtered_resources_provider A, filtered_resources_provider B>
+	using TConflictingResources = decltype(std::tuple_cat(
+		std::declval<typename CConflictingResourceList<decltype(A::GetFilteredResources()),
+		                                               decltype(B::GetFilteredResources())>::TTypes>(),
+		std::declval<typename CConflictingResourceList<decltype(B::GetFilteredResources()),
+		                                               decltype(A::GetFilteredResources())>::TTypes>()
+	));
+
+	// defined with CNoResources, accessing it never needs a parent resource
+	struct CNoType;
+
+	/**
+	 * \brief Checks if the resource access T is allowed by the resource access U,
+	 *        which is the case if U accesses the same member or the whole object and U writes it or T only reads it.
+	 * \tparam T The resource access of a subtask
+	 * \tparam U The resource access of the parent task
+	 */
+	template <typename T, typename U>
+	concept covered_access = member_resource_access<T> && member_resource_access<U>
+		&& std::is_same_v<typename T::TType, typename U::TType>
+		&& (std::is_same_v<typename T::TMember, typename U::TMember> || object_resource_access<U>)
+		&& (T::ACCESS_MODE == EResourceAccessMode::READ || U::ACCESS_MODE == EResourceAccessMode::WRITE);
+
+	/**
+	 * \brief True if the resource access T is allowed by any of the resource accesses Us.
+	 */
+	template <member_resource_access T, member_resource_access... Us>
+	constexpr bool COVERED_BY_ANY = std::is_same_v<typename T::TType, CNoType> || (covered_access<T, Us> || ...);
+
+	/**
+	 * \brief Checks if every resource of the first tuple is allowed by the resources of the second tuple.
+	 * \return true if the first tuple is a subset of the second one
+	 */
+	template <member_resource_access... Ts, member_resource_access... Us>
+	constexpr bool IsCovered(std::tuple<Ts...>, std::tuple<Us...>)
+	{
+		return (COVERED_BY_ANY<Ts, Us...> && ...);
+	}
+
+	/**
+	 * \brief True if Child only accesses resources of Parent and only writes the ones Parent writes.
+	 *        Such a Child may run inside of Parent without being scheduled against the other tasks.
+	 * \tparam Child CMethodResources or CTask
+	 * \tparam Parent CMethodResources or CTask
+	 */
+	template <filtered_resources_provider Child, filtered_resources_provider Parent>
+	constexpr bool resource_subset_v = IsCovered(Child::GetFilteredResources(), Parent::GetFilteredResources());
+
 	/*
 	 * ####################################
 	 * resource definition for a method
@@ -371,6 +656,20 @@ namespace Meta
 		}
 	};
 
+	/**
+	 * \brief Declared execution time of a method resource.
+	 * \tparam T CMethodResources
+	 * \return T::ESTIMATED_COST or zero if T declares no cost
+	 */
+	template <typename T>
+	constexpr std::chrono::nanoseconds GetEstimatedCost()
+	{
+		if constexpr (cost_annotated<T>)
+			return T::ESTIMATED_COST;
+		else
+			return std::chrono::nanoseconds::zero();
+	}
+
 	/**
 	 * \brief Holds the list of MethodResources.
 	 * \tparam MethodAnnotations List of method resources.
@@ -0,0 +1,113 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <tuple>
+#include <typeinfo>
+#include <type_traits>
+#include <vector>
+
+#include "Meta.hpp"
+
+namespace Meta
+{
+	/**
+	 * \brief Runtime description of one resource access,
+	 *        for everything that cannot work on the resource types directly (diagnostics, statistics, ...).
+	 */
+	struct CResourceAccessInfo
+	{
+		// same as CMemberResourceAccess::GetHashCode
+		size_t hashCode = 0;
+		EResourceAccessMode accessMode = EResourceAccessMode::READ;
+		// hash code of the class owning the member
+		size_t classHashCode = 0;
+		// hash code of the access to the whole object of the class, same as hashCode for object accesses
+		size_t objectHashCode = 0;
+		// the access covers all members of the class, see CObjectResourceAccess
+		bool objectLevel = false;
+		std::string_view className;
+		std::string_view memberName;
+		// byte offset of the member inside its class or UNKNOWN_MEMBER_OFFSET
+		size_t memberOffset = UNKNOWN_MEMBER_OFFSET;
+		size_t memberSize = 0;
+		// alignment of the class, objects are placed at a multiple of it
+		size_t classAlignment = 1;
+	};
+
+	/**
+	 * \brief Index of a resource hash code in a table with a power of two of slots, e.g. of locks or counters.
+	 *        The hash codes are often addresses with empty low bits, the high bits of the product mix all of them.
+	 * \param hash_code Hash code of the resource
+	 * \param num_slots Number of slots, a power of two of at least 2
+	 */
+	inline size_t GetResourceSlot(const size_t hash_code, const size_t num_slots)
+	{
+		return static_cast<size_t>((static_cast<uint64_t>(hash_code) * 0x9E3779B97F4A7C15ull)
+			>> (64 - std::countr_zero(num_slots)));
+	}
+
+	/**
+	 * \brief Creates the runtime description of a resource access.
+	 * \tparam Resource CMemberResourceAccess type
+	 * \return CResourceAccessInfo
+	 */
+	template <member_resource_access Resource>
+	CResourceAccessInfo GetResourceAccessInfo()
+	{
+		using TMember = typename Resource::TMember;
+		using TMemberType = typename TMember::TMemberType;
+
+		CResourceAccessInfo info{};
+		info.hashCode = Resource::GetHashCode();
+		info.accessMode = Resource::ACCESS_MODE;
+		info.classHashCode = typeid(typename Resource::TType).hash_code();
+		info.objectHashCode = CObjectResourceAccess<typename Resource::TType, EResourceAccessMode::READ>::GetHashCode();
+		info.objectLevel = object_resource_access<Resource>;
+		info.className = GetTypeName<typename Resource::TType>();
+		// private members have a name, public members are described by their member pointer
+		if constexpr (member_field<TMember>)
+			info.memberName = TMember::MEMBER_NAME.value;
+		else if constexpr (requires { TMember::GetMemberName(); })
+			info.memberName = TMember::GetMemberName();
+		if (info.memberName.empty())
+			info.memberName = GetTypeName<TMember>();
+		if constexpr (requires { TMember::MEMBER_OFFSET; })
+			info.memberOffset = TMember::MEMBER_OFFSET;
+		if constexpr (!std::is_void_v<TMemberType>)
+			info.memberSize = sizeof(TMemberType);
+		if constexpr (complete_type<typename Resource::TType>)
+			info.classAlignment = alignof(typename Resource::TType);
+		return info;
+	}
+
+	/**
+	 * \brief Coarse set of classes with one bit per class hash code.
+	 *        A clear bit means that the class is not in the set, a set bit has to be confirmed on member granularity,
+	 *        so the lookups for the members of a class can be skipped in most cases.
+	 */
+	struct CClassSummary
+	{
+		std::uint64_t bits = 0;
+
+		static constexpr std::uint64_t GetBit(const size_t class_hash_code)
+		{
+			return std::uint64_t{1} << (class_hash_code % 64);
+		}
+
+		void Add(const size_t class_hash_code) { bits |= GetBit(class_hash_code); }
+		bool MayContain(const size_t class_hash_code) const { return (bits & GetBit(class_hash_code)) != 0; }
+	};
+
+	/**
+	 * \brief Creates the runtime descriptions of all resource accesses of a tuple.
+	 * \tparam Resources Resources of the tuple, usually the result of GetFilteredResources
+	 * \return std::vector<CResourceAccessInfo> in the same order as the tuple
+	 */
+	template <member_resource_access... Resources>
+	std::vector<CResourceAccessInfo> GetResourceAccessInfos(std::tuple<Resources...>)
+	{
+		return {GetResourceAccessInfo<Resources>()...};
+	}
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+#include "Meta.hpp"
+
+namespace Meta
+{
+	/**
+	 * \brief Computes the execution graph of a fixed list of tasks at compile time.
+	 *        The tasks are ordered like a task queue: if two tasks conflict,
+	 *        the one listed first is executed first.
+	 *        The graph is transitively reduced, so a task only depends on its direct predecessors.
+	 * \tparam Tasks List of tasks (or method resources) with a static GetFilteredResources()
+	 */
+	template <filtered_resources_provider... Tasks>
+	struct CStaticSchedule
+	{
+		using TTasks = std::tuple<Tasks...>;
+		using TMatrix = std::array<std::array<bool, sizeof...(Tasks)>, sizeof...(Tasks)>;
+		using TIndices = std::array<size_t, sizeof...(Tasks)>;
+
+		static constexpr size_t NUM_TASKS = sizeof...(Tasks);
+
+		// conflicts of the given task with every task of the list
+		template <typename Task>
+		static constexpr std::array<bool, NUM_TASKS> CONFLICTS_ROW{conflicts_v<Task, Tasks>...};
+
+		/**
+		 * \brief Index of the given task inside the task list.
+		 * \tparam Task The task to look for, has to be listed exactly once
+		 */
+		template <typename Task>
+		static constexpr size_t INDEX_OF = []
+		{
+			static_assert((std::is_same_v<Task, Tasks> + ... + 0) == 1, "Task has to be listed exactly once.");
+			constexpr std::array<bool, NUM_TASKS> matches{std::is_same_v<Task, Tasks>...};
+			size_t idx = 0;
+			while (!matches[idx])
+				++idx;
+			return idx;
+		}();
+
+		// CONFLICTS[a][b] is true if tasks a and b may not run at the same time
+		static constexpr TMatrix CONFLICTS = []
+		{
+			TMatrix conflicts{CONFLICTS_ROW<Tasks>...};
+			// a task never waits for itself
+			for (size_t idx = 0; idx < NUM_TASKS; ++idx)
+				conflicts[idx][idx] = false;
+			return conflicts;
+		}();
+
+		// EDGES[parent][child] is true if child has to wait for parent
+		static constexpr TMatrix EDGES = []
+		{
+			// reach[a][b] is true if there is any path from a to b
+			TMatrix reach = CONFLICTS;
+			for (size_t from = 0; from < NUM_TASKS; ++from)
+				for (size_t to = 0; to <= from; ++to)
+					reach[from][to] = false;
+			for (size_t from = NUM_TASKS; from-- > 0;)
+				for (size_t via = from + 1; via < NUM_TASKS; ++via)
+					if (reach[from][via])
+						for (size_t to = via + 1; to < NUM_TASKS; ++to)
+							reach[from][to] = reach[from][to] || reach[via][to];
+
+			// keep only the edges that are not implied by a longer path
+			TMatrix edges{};
+			for (size_t from = 0; from < NUM_TASKS; ++from)
+				for (size_t to = from + 1; to < NUM_TASKS; ++to)
+				{
+					if (!CONFLICTS[from][to])
+						continue;
+					bool implied = false;
+					for (size_t via = from + 1; via < to && !implied; ++via)
+						implied = CONFLICTS[from][via] && reach[via][to];
+					edges[from][to] = !implied;
+				}
+			return edges;
+		}();
+
+		// number of direct predecessors of each task
+		static constexpr TIndices IN_DEGREES = []
+		{
+			TIndices inDegrees{};
+			for (size_t from = 0; from < NUM_TASKS; ++from)
+				for (size_t to = 0; to < NUM_TASKS; ++to)
+					inDegrees[to] += EDGES[from][to];
+			return inDegrees;
+		}();
+
+		// topological level of each task, tasks on the same level never conflict
+		static constexpr TIndices LEVELS = []
+		{
+			TIndices levels{};
+			for (size_t to = 0; to < NUM_TASKS; ++to)
+				for (size_t from = 0; from < to; ++from)
+					if (EDGES[from][to] && levels[from] + 1 > levels[to])
+						levels[to] = levels[from] + 1;
+			return levels;
+		}();
+
+		// number of levels, which is the length of the longest dependency chain
+		static constexpr size_t DEPTH = []
+		{
+			size_t depth = 0;
+			for (const size_t level : LEVELS)
+				if (level + 1 > depth)
+					depth = level + 1;
+			return depth;
+		}();
+
+		// task indices sorted by level, the execution order of the tasks
+		static constexpr TIndices ORDER = []
+		{
+			TIndices order{};
+			size_t pos = 0;
+			for (size_t level = 0; level < DEPTH; ++level)
+				for (size_t idx = 0; idx < NUM_TASKS; ++idx)
+					if (LEVELS[idx] == level)
+						order[pos++] = idx;
+			return order;
+		}();
+
+		/**
+		 * \brief True if the given tasks never conflict and may run at the same time.
+		 */
+		template <typename TaskA, typename TaskB>
+		static constexpr bool CONCURRENT = !CONFLICTS[INDEX_OF<TaskA>][INDEX_OF<TaskB>];
+	};
+}